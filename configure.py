@@ -17,7 +17,7 @@ writer = generator.writer
 toolchain = generator.toolchain
 
 network_lib = generator.lib(module = 'network', sources = [
-  'address.c', 'network.c', 'poll.c', 'socket.c', 'stream.c', 'tcp.c', 'udp.c', 'version.c'])
+  'address.c', 'dispatch.c', 'network.c', 'poll.c', 'pollgroup.c', 'polltimer.c', 'socket.c', 'stream.c', 'tcp.c', 'udp.c', 'version.c'])
 
 #No test cases if we're a submodule
 if generator.is_subninja():
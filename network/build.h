@@ -21,3 +21,11 @@
 /*! Dump network traffic to log (debug). Dump read/write information if > 0,
 dump full traffic (payload data) if > 1 */
 #define BUILD_ENABLE_NETWORK_DUMP_TRAFFIC     0
+
+/*! Enable the io_uring network poll backend (Linux only). A poll requesting the
+backend falls back to epoll at runtime if the kernel lacks io_uring support */
+#if FOUNDATION_PLATFORM_LINUX
+#define BUILD_ENABLE_NETWORK_IO_URING         1
+#else
+#define BUILD_ENABLE_NETWORK_IO_URING         0
+#endif
@@ -0,0 +1,184 @@
+/* dispatch.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/dispatch.h>
+#include <network/poll.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#define NETWORK_DISPATCH_BUDGET 64
+
+network_dispatch_t*
+network_dispatch_allocate(network_poll_t* poll, size_t budget) {
+	network_dispatch_t* dispatch;
+	if (!budget)
+		budget = NETWORK_DISPATCH_BUDGET;
+	FOUNDATION_ASSERT_MSG(!poll->dispatch, "Poll already has a dispatcher");
+	dispatch = memory_allocate(HASH_NETWORK, sizeof(network_dispatch_t) +
+	                           sizeof(network_poll_event_t) * budget, 0,
+	                           MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	dispatch->poll = poll;
+	dispatch->budget = budget;
+	poll->dispatch = dispatch;
+	return dispatch;
+}
+
+void
+network_dispatch_deallocate(network_dispatch_t* dispatch) {
+	if (!dispatch)
+		return;
+	if (dispatch->poll->dispatch == dispatch)
+		dispatch->poll->dispatch = nullptr;
+	array_deallocate(dispatch->deferred);
+	memory_deallocate(dispatch);
+}
+
+network_poll_t*
+network_dispatch_poll(network_dispatch_t* dispatch) {
+	return dispatch->poll;
+}
+
+void
+network_dispatch_set_default_handler(network_dispatch_t* dispatch, const network_handler_t* handler,
+                                     void* context) {
+	dispatch->handler = handler;
+	dispatch->context = context;
+}
+
+void
+network_dispatch_set_class_budget(network_dispatch_t* dispatch, network_poll_priority_t priority,
+                                  size_t budget) {
+	if (priority < NETWORK_POLL_PRIORITY_COUNT)
+		dispatch->class_budget[priority] = budget;
+}
+
+bool
+network_dispatch_add_socket(network_dispatch_t* dispatch, socket_t* sock,
+                            const network_handler_t* handler, void* context) {
+	if (!network_poll_add_socket(dispatch->poll, sock))
+		return false;
+	network_dispatch_set_handler(dispatch, sock, handler, context);
+	return true;
+}
+
+void
+network_dispatch_set_handler(network_dispatch_t* dispatch, socket_t* sock,
+                             const network_handler_t* handler, void* context) {
+	network_poll_slot_t* slot;
+	if (sock->poll != dispatch->poll)
+		return;
+	slot = dispatch->poll->slots + sock->poll_slot;
+	slot->handler = handler;
+	slot->context = context;
+}
+
+void*
+network_dispatch_context(network_dispatch_t* dispatch, const socket_t* sock) {
+	if (sock->poll != dispatch->poll)
+		return nullptr;
+	return dispatch->poll->slots[sock->poll_slot].context;
+}
+
+//Return events exceeding the budget of their priority class to the poll
+static void
+network_dispatch_limit(network_dispatch_t* dispatch) {
+	size_t num_class[NETWORK_POLL_PRIORITY_COUNT] = {0};
+	size_t ievt, ikeep;
+	array_clear(dispatch->deferred);
+	for (ievt = 0, ikeep = 0; ievt < dispatch->count; ++ievt) {
+		const network_poll_event_t* event = dispatch->events + ievt;
+		unsigned int priority = _network_poll_event_priority(dispatch->poll, event);
+		size_t budget = dispatch->class_budget[priority];
+		if (budget && (num_class[priority]++ >= budget))
+			array_push(dispatch->deferred, *event);
+		else
+			dispatch->events[ikeep++] = *event;
+	}
+	if (ikeep < dispatch->count) {
+		_network_poll_requeue(dispatch->poll, dispatch->deferred, array_size(dispatch->deferred));
+		dispatch->count = ikeep;
+	}
+}
+
+size_t
+network_dispatch(network_dispatch_t* dispatch, unsigned int timeoutms) {
+	network_poll_t* poll = dispatch->poll;
+	size_t num_dispatched = 0;
+	tick_t start;
+
+	FOUNDATION_ASSERT_MSG(dispatch->next >= dispatch->count, "Recursive network dispatch");
+
+	dispatch->next = 0;
+	dispatch->count = network_poll(poll, dispatch->events, dispatch->budget, timeoutms);
+	if (dispatch->class_budget[NETWORK_POLL_PRIORITY_HIGH] ||
+	    dispatch->class_budget[NETWORK_POLL_PRIORITY_NORMAL] ||
+	    dispatch->class_budget[NETWORK_POLL_PRIORITY_LOW])
+		network_dispatch_limit(dispatch);
+
+	start = (poll->flags & NETWORK_POLLFLAG_INSTRUMENTED) ? time_current() : 0;
+
+	while (dispatch->next < dispatch->count) {
+		const network_poll_event_t* event = dispatch->events + dispatch->next++;
+		const network_handler_t* handler = dispatch->handler;
+		void* context = dispatch->context;
+		network_handler_fn fn;
+
+		//Discarded event of a socket removed by an earlier handler
+		if (!event->event)
+			continue;
+
+		if (event->socket && (event->socket->poll == poll)) {
+			const network_poll_slot_t* slot = poll->slots + event->socket->poll_slot;
+			if (slot->handler) {
+				handler = slot->handler;
+				context = slot->context;
+			}
+		}
+
+		fn = handler ? handler->event[event->event] : nullptr;
+		if (fn)
+			fn(dispatch, event, context);
+		++num_dispatched;
+	}
+
+	//Handlers may have disabled instrumentation
+	if (start && num_dispatched && (poll->flags & NETWORK_POLLFLAG_INSTRUMENTED))
+		_network_poll_histogram_record(&poll->statistics.dispatch,
+		                               _network_poll_ticks_to_us(time_elapsed_ticks(start)));
+
+	return num_dispatched;
+}
+
+void
+network_dispatch_run(network_dispatch_t* dispatch, unsigned int timeoutms) {
+	dispatch->running = true;
+	while (dispatch->running)
+		network_dispatch(dispatch, timeoutms);
+}
+
+void
+network_dispatch_stop(network_dispatch_t* dispatch) {
+	dispatch->running = false;
+}
+
+void
+_network_dispatch_remove_socket(network_dispatch_t* dispatch, socket_t* sock) {
+	size_t ievt;
+	for (ievt = dispatch->next; ievt < dispatch->count; ++ievt) {
+		if (dispatch->events[ievt].socket == sock) {
+			//Send completions still hand their buffer back
+			if (dispatch->events[ievt].event != NETWORKEVENT_SEND_COMPLETE)
+				dispatch->events[ievt].event = 0;
+			dispatch->events[ievt].socket = nullptr;
+		}
+	}
+}
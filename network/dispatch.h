@@ -0,0 +1,110 @@
+/* dispatch.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file dispatch.h
+    Reactor style event dispatch on top of a network poll. Each socket in the poll can
+    have a handler table and a user context, and events are dispatched directly to the
+    handler function for the event id. Events without a socket handler table (including
+    timer events) are dispatched to the default handler table of the dispatcher. Handlers
+    are called on the thread running the dispatcher and may freely add, remove and
+    deallocate sockets, pending events for removed sockets are discarded except send
+    completions, which are dispatched without the socket to the default handler. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Allocate a dispatcher for a poll
+\param poll Poll, must outlive the dispatcher
+\param budget Maximum number of events dispatched per iteration, 0 for default. Events
+              exceeding the budget are dispatched in the next iteration
+\return New dispatcher */
+NETWORK_API network_dispatch_t*
+network_dispatch_allocate(network_poll_t* poll, size_t budget);
+
+/*! Deallocate a dispatcher. The poll and its sockets are not deallocated.
+\param dispatch Dispatcher */
+NETWORK_API void
+network_dispatch_deallocate(network_dispatch_t* dispatch);
+
+/*! Get the poll driven by the dispatcher
+\param dispatch Dispatcher
+\return Poll */
+NETWORK_API network_poll_t*
+network_dispatch_poll(network_dispatch_t* dispatch);
+
+/*! Set the default handler table, used for events without a socket handler table
+\param dispatch Dispatcher
+\param handler Handler table, must remain valid while set. Null to ignore events
+\param context User context passed to handler functions */
+NETWORK_API void
+network_dispatch_set_default_handler(network_dispatch_t* dispatch, const network_handler_t* handler,
+                                     void* context);
+
+/*! Set the maximum number of events of a priority class dispatched per iteration.
+Events exceeding the budget of their class are returned to the poll and dispatched
+first in the next iteration, letting events of other classes through.
+\param dispatch Dispatcher
+\param priority Priority class
+\param budget Maximum number of events per iteration, 0 for no limit other than the
+              dispatcher budget */
+NETWORK_API void
+network_dispatch_set_class_budget(network_dispatch_t* dispatch, network_poll_priority_t priority,
+                                  size_t budget);
+
+/*! Add a socket to the poll with a handler table and user context
+\param dispatch Dispatcher
+\param sock Socket
+\param handler Handler table, must remain valid while the socket is in the poll
+\param context User context passed to handler functions
+\return true if added, false if error */
+NETWORK_API bool
+network_dispatch_add_socket(network_dispatch_t* dispatch, socket_t* sock,
+                            const network_handler_t* handler, void* context);
+
+/*! Replace the handler table and user context of a socket in the poll, for example
+to switch state machine on a socket changing state
+\param dispatch Dispatcher
+\param sock Socket
+\param handler Handler table, null to use the default handler table
+\param context User context passed to handler functions */
+NETWORK_API void
+network_dispatch_set_handler(network_dispatch_t* dispatch, socket_t* sock,
+                             const network_handler_t* handler, void* context);
+
+/*! Get the user context of a socket in the poll
+\param dispatch Dispatcher
+\param sock Socket
+\return User context, null if socket not in poll */
+NETWORK_API void*
+network_dispatch_context(network_dispatch_t* dispatch, const socket_t* sock);
+
+/*! Run one dispatch iteration, polling for at most the event budget and calling the
+handlers for each event
+\param dispatch Dispatcher
+\param timeoutms Timeout in milliseconds to wait for events
+\return Number of events dispatched */
+NETWORK_API size_t
+network_dispatch(network_dispatch_t* dispatch, unsigned int timeoutms);
+
+/*! Run dispatch iterations until #network_dispatch_stop is called
+\param dispatch Dispatcher
+\param timeoutms Timeout in milliseconds of each iteration wait */
+NETWORK_API void
+network_dispatch_run(network_dispatch_t* dispatch, unsigned int timeoutms);
+
+/*! Stop #network_dispatch_run after the current iteration. Must be called from a
+handler or the thread running the dispatcher.
+\param dispatch Dispatcher */
+NETWORK_API void
+network_dispatch_stop(network_dispatch_t* dispatch);
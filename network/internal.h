@@ -26,7 +26,7 @@
 #elif FOUNDATION_PLATFORM_POSIX
 #  include <foundation/posix.h>
 #  include <fcntl.h>
-#  include <sys/select.h>
+#  include <poll.h>
 #  include <arpa/inet.h>
 #  include <netinet/in.h>
 #  include <netdb.h>
@@ -49,9 +49,31 @@ typedef enum {
 	SOCKETFLAG_BLOCKING             = 0x00000001,
 	SOCKETFLAG_TCPDELAY             = 0x00000002,
 	SOCKETFLAG_REUSE_ADDR           = 0x00000004,
-	SOCKETFLAG_REUSE_PORT           = 0x00000008
+	SOCKETFLAG_REUSE_PORT           = 0x00000008,
+	SOCKETFLAG_DRAINED              = 0x00000010,
+	SOCKETFLAG_POLL_WRITE           = 0x00000020,
+	SOCKETFLAG_ZEROCOPY             = 0x00000040,
+	SOCKETFLAG_ADDRESS_LOCAL_LAZY   = 0x00000080,
+	SOCKETFLAG_OUTPUT_QUEUED        = 0x00000100,
+	SOCKETFLAG_OUTPUT_HIGH          = 0x00000200,
+	SOCKETFLAG_TCPCORK              = 0x00000400,
+	SOCKETFLAG_TCPQUICKACK          = 0x00000800,
+	SOCKETFLAG_KEEPALIVE            = 0x00001000
 } socket_flag_t;
 
+typedef enum {
+	NETWORK_POLLFLAG_EDGE_TRIGGERED = 0x00000001,
+	NETWORK_POLLFLAG_GROWABLE       = 0x00000002,
+	NETWORK_POLLFLAG_DEFERRED       = 0x00000004,
+	NETWORK_POLLFLAG_WOKEN          = 0x00000008,
+	NETWORK_POLLFLAG_INSTRUMENTED   = 0x00000010
+} network_poll_flag_t;
+
+typedef enum {
+	NETWORK_POLL_REQUEST_ADD = 0,
+	NETWORK_POLL_REQUEST_REMOVE
+} network_poll_request_op_t;
+
 #if FOUNDATION_PLATFORM_WINDOWS
 #  define NETWORK_SOCKET_ERROR ((int)WSAGetLastError())
 #  define NETWORK_RESOLV_ERROR NETWORK_SOCKET_ERROR
@@ -68,14 +90,91 @@ _socket_create_fd(socket_t* sock, network_address_family_t family);
 NETWORK_API void
 _socket_initialize(socket_t* sock);
 
+NETWORK_API void
+_socket_pool_initialize(void);
+
+NETWORK_API void
+_socket_pool_finalize(void);
+
+NETWORK_API void
+_socket_pool_thread_finalize(void);
+
+NETWORK_API socket_t*
+_socket_allocate(void);
+
+
 NETWORK_API void
 _socket_close_fd(int fd);
 
+NETWORK_API bool
+_socket_address_initialize(network_address_storage_t* address, int family);
+
+NETWORK_API void
+_socket_set_address_remote(socket_t* sock, const network_address_t* address);
+
 NETWORK_API void
-_socket_store_address_local(socket_t* sock, int family);
+_socket_defer_address_local(socket_t* sock);
+
+NETWORK_API bool
+_socket_has_address_local(const socket_t* sock);
 
 NETWORK_API int
 _socket_available_fd(int fd);
 
+NETWORK_API int
+_socket_poll_fd(int fd, unsigned int events, unsigned int timeoutms);
+
+NETWORK_API bool
+_socket_set_option(socket_t* sock, int level, int name, int value, const char* option, size_t length);
+
+NETWORK_API void
+_socket_write_failed(socket_t* sock, size_t total_write, size_t size);
+
+NETWORK_API size_t
+_socket_output_flush(socket_t* sock);
+
+NETWORK_API void
+_network_poll_timers_finalize(network_poll_t* poll);
+
+NETWORK_API unsigned int
+_network_poll_timers_update(network_poll_t* poll, unsigned int timeoutms);
+
+NETWORK_API size_t
+_network_poll_timers_expired(network_poll_t* poll, network_poll_event_t* events, size_t capacity);
+
+NETWORK_API void
+_network_poll_timers_socket_events(network_poll_t* poll, const network_poll_event_t* events,
+                                   size_t num_events);
+
+NETWORK_API void
+_network_poll_timers_remove_socket(network_poll_t* poll, network_poll_slot_t* slot);
+
+NETWORK_API void
+_network_poll_apply_queue(network_poll_t* poll);
+
+NETWORK_API void
+_network_poll_queue_purge(network_poll_t* poll, socket_t* sock);
+
+NETWORK_API void
+_network_poll_histogram_record(network_poll_histogram_t* histogram, uint64_t value);
+
+NETWORK_API uint64_t
+_network_poll_ticks_to_us(tick_t ticks);
+
+NETWORK_API unsigned int
+_network_poll_event_priority(network_poll_t* poll, const network_poll_event_t* event);
+
+NETWORK_API void
+_network_poll_requeue(network_poll_t* poll, const network_poll_event_t* events, size_t num_events);
+
+NETWORK_API void
+_network_poll_push(network_poll_t* poll, network_event_id event, socket_t* sock, int result);
+
+NETWORK_API void
+_network_poll_zerocopy_cancel(network_poll_t* poll, socket_t* sock, bool removed);
+
+NETWORK_API void
+_network_dispatch_remove_socket(network_dispatch_t* dispatch, socket_t* sock);
+
 NETWORK_API int
 socket_streams_initialize(void);
@@ -55,6 +55,8 @@ network_module_initialize(const network_config_t config) {
 	if (socket_streams_initialize() < 0)
 		return -1;
 
+	_socket_pool_initialize();
+
 	//Check support
 	fd = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	_network_supports_ipv4 = !(fd < 0);
@@ -93,9 +95,20 @@ network_module_finalize(void) {
 
 	log_debug(HASH_NETWORK, STRING_CONST("Terminating network services"));
 
+	//All sockets must be deallocated
+	_socket_pool_finalize();
+
 #if FOUNDATION_PLATFORM_WINDOWS
 	WSACleanup();
 #endif
+
+	_network_initialized = false;
+}
+
+void
+network_thread_finalize(void) {
+	if (_network_initialized)
+		_socket_pool_thread_finalize();
 }
 
 network_config_t
@@ -20,6 +20,9 @@
 #include <network/hashstrings.h>
 #include <network/address.h>
 #include <network/poll.h>
+#include <network/dispatch.h>
+#include <network/pollgroup.h>
+#include <network/polltimer.h>
 #include <network/socket.h>
 #include <network/stream.h>
 #include <network/tcp.h>
@@ -38,6 +41,13 @@ another call to #network_module_initialize. */
 NETWORK_API void
 network_module_finalize(void);
 
+/*! Return sockets cached by the calling thread to the pool shared by all threads. Call
+before a thread that deallocated sockets exits, otherwise the sockets cached by the
+thread (at most 512) are not reused until #network_module_finalize. Threads of a
+#network_poll_group_t call this on exit. */
+NETWORK_API void
+network_thread_finalize(void);
+
 /*! Query if network module is initialized properly
 \return true if initialized, false if not */
 NETWORK_API bool
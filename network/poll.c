@@ -24,51 +24,415 @@
 #endif
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
 #  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  include <linux/errqueue.h>
 #elif FOUNDATION_PLATFORM_MACOS || FOUNDATION_PLATFORM_IOS
 #  include <sys/poll.h>
+#  include <fcntl.h>
 #endif
+#if BUILD_ENABLE_NETWORK_IO_URING
+#  include <sys/poll.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <linux/io_uring.h>
+#endif
+#if FOUNDATION_PLATFORM_POSIX && !defined(POLLRDHUP)
+//Peer shutdown is then seen once the peer closes the socket or reading returns zero
+#  define POLLRDHUP 0
+#endif
+
+//Write readiness is polled for the application or to flush queued output
+#define NETWORK_POLL_WRITE_MASK (SOCKETFLAG_POLL_WRITE | SOCKETFLAG_OUTPUT_QUEUED)
+
+#define network_poll_push_event(pollobj, events, capacity, num, evt, sock) \
+	network_poll_push_completion(pollobj, events, capacity, num, evt, sock, 0, 0)
+
+//Events beyond capacity are kept in the poll and returned by the next call
+#define network_poll_push_completion(pollobj, events, capacity, num, evt, sock, buf, res) \
+	do { \
+		network_poll_event_t* _evt; \
+		if ((num) < (capacity)) { \
+			_evt = (events) + (num); \
+			++(num); \
+		} \
+		else { \
+			array_resize((pollobj)->pending, array_size((pollobj)->pending) + 1); \
+			_evt = (pollobj)->pending + array_size((pollobj)->pending) - 1; \
+		} \
+		_evt->event = (evt); \
+		_evt->socket = (sock); \
+		_evt->buffer = (buf); \
+		_evt->result = (res); \
+	} while (false)
+
+//Flush queued output of a writable socket, notifying when it drains to the low watermark.
+//Returns true if the queue emptied or the socket failed and the slot needs updating
+static bool
+network_poll_flush_output(network_poll_t* pollobj, socket_t* sock, network_poll_event_t* events,
+                          size_t capacity, size_t* num_events) {
+	size_t queued = _socket_output_flush(sock);
+	if ((sock->flags & SOCKETFLAG_OUTPUT_HIGH) && (queued <= sock->output_low)) {
+		sock->flags &= ~SOCKETFLAG_OUTPUT_HIGH;
+		network_poll_push_completion(pollobj, events, capacity, *num_events, NETWORKEVENT_OUTPUT_LOW,
+		                             sock, nullptr, (int)queued);
+	}
+	return !(sock->flags & SOCKETFLAG_OUTPUT_QUEUED);
+}
+
+#if BUILD_ENABLE_NETWORK_IO_URING
+#define NETWORK_POLL_URING_ENTRIES   256
+#define NETWORK_POLL_URING_OP_NONE   0
+#define NETWORK_POLL_URING_IGNORE    ((uint64_t)-1)
+#define NETWORK_POLL_URING_TIMEOUT   ((uint64_t)-2)
+#define NETWORK_POLL_URING_WAKEUP    ((uint64_t)-3)
+
+typedef enum {
+	NETWORK_POLL_URING_OP_POLL = 1,
+	NETWORK_POLL_URING_OP_READ,
+	NETWORK_POLL_URING_OP_WRITE,
+	NETWORK_POLL_URING_OP_FD
+} network_poll_uring_op_id;
+
+static network_poll_uring_t*
+network_poll_uring_allocate(unsigned int entries);
+
+static void
+network_poll_uring_deallocate(network_poll_uring_t* uring);
+
+static void
+network_poll_uring_arm_wakeup(network_poll_t* pollobj);
+
+static void
+network_poll_uring_update_slot(network_poll_uring_t* uring, network_poll_slot_t* slot, socket_t* sock);
+
+static void
+network_poll_uring_remove_slot(network_poll_uring_t* uring, network_poll_slot_t* slot);
+
+static void
+network_poll_uring_update_fd(network_poll_uring_t* uring, network_poll_fd_t* entry);
+
+static void
+network_poll_uring_remove_fd(network_poll_uring_t* uring, network_poll_fd_t* entry);
+
+static bool
+network_poll_uring_submit_io(network_poll_t* pollobj, socket_t* sock, unsigned int type,
+                             void* buffer, size_t size);
+#endif
+
+#define NETWORK_POLL_MIN_GROW 8
+
+//Raw descriptor registrations are tagged in the low bit of the epoll data pointer
+#define NETWORK_POLL_FD_TAG 1
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+#  ifndef SO_BUSY_POLL
+#    define SO_BUSY_POLL 46
+#  endif
+#  ifndef SO_PREFER_BUSY_POLL
+#    define SO_PREFER_BUSY_POLL 69
+#  endif
+#endif
+
+//Backend arrays have one extra entry for the wakeup descriptor
+static size_t
+network_poll_storage_size(size_t num_sockets) {
+	size_t memsize = sizeof(network_poll_slot_t) * num_sockets;
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	memsize += sizeof(struct epoll_event) * (num_sockets + 1);
+#endif
+#if FOUNDATION_PLATFORM_POSIX
+	memsize += sizeof(struct pollfd) * (num_sockets + 1);
+#endif
+	return memsize;
+}
+
+static void
+network_poll_set_storage(network_poll_t* pollobj, void* storage, size_t num_sockets) {
+	pollobj->slots = storage;
+	pollobj->max_sockets = num_sockets;
+	storage = pointer_offset(storage, sizeof(network_poll_slot_t) * num_sockets);
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	pollobj->events = storage;
+	storage = pointer_offset(storage, sizeof(struct epoll_event) * (num_sockets + 1));
+#endif
+#if FOUNDATION_PLATFORM_POSIX
+	pollobj->pollfds = storage;
+#else
+	FOUNDATION_UNUSED(storage);
+#endif
+}
+
+//Descriptor signalling readable on wakeup
+static int
+network_poll_wakeup_fd(const network_poll_t* pollobj) {
+#if FOUNDATION_PLATFORM_APPLE
+	return pollobj->fd_wakeup[0];
+#else
+	return pollobj->fd_wakeup;
+#endif
+}
+
+static bool
+network_poll_has_wakeup(const network_poll_t* pollobj) {
+	return (network_poll_wakeup_fd(pollobj) != NETWORK_SOCKET_INVALID);
+}
+
+static void
+network_poll_wakeup_initialize(network_poll_t* pollobj) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	struct epoll_event event;
+	pollobj->fd_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (pollobj->fd_wakeup >= 0) {
+		//Poll pointer never aliases a socket pointer, marks the wakeup registration
+		event.events = EPOLLIN;
+		event.data.ptr = pollobj;
+		epoll_ctl(pollobj->fd_poll, EPOLL_CTL_ADD, pollobj->fd_wakeup, &event);
+	}
+#elif FOUNDATION_PLATFORM_APPLE
+	if (pipe(pollobj->fd_wakeup) == 0) {
+		fcntl(pollobj->fd_wakeup[0], F_SETFL, O_NONBLOCK);
+		fcntl(pollobj->fd_wakeup[1], F_SETFL, O_NONBLOCK);
+	}
+	else {
+		pollobj->fd_wakeup[0] = pollobj->fd_wakeup[1] = NETWORK_SOCKET_INVALID;
+	}
+#elif FOUNDATION_PLATFORM_WINDOWS
+	//Loopback datagram socket connected to itself, select can only wait on sockets
+	struct sockaddr_in addr;
+	int addrlen = sizeof(addr);
+	u_long nonblocking = 1;
+	int fd = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ((fd != NETWORK_SOCKET_INVALID) &&
+	    ((bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+	     (getsockname(fd, (struct sockaddr*)&addr, &addrlen) != 0) ||
+	     (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0))) {
+		_socket_close_fd(fd);
+		fd = NETWORK_SOCKET_INVALID;
+	}
+	if (fd != NETWORK_SOCKET_INVALID)
+		ioctlsocket(fd, FIONBIO, &nonblocking);
+	pollobj->fd_wakeup = fd;
+#endif
+	if (!network_poll_has_wakeup(pollobj)) {
+		int err = NETWORK_SOCKET_ERROR;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Network poll: Unable to create wakeup descriptor: %.*s (%d)"),
+		          STRING_FORMAT(errmsg), err);
+	}
+}
+
+static void
+network_poll_wakeup_finalize(network_poll_t* pollobj) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->fd_wakeup >= 0)
+		close(pollobj->fd_wakeup);
+	pollobj->fd_wakeup = NETWORK_SOCKET_INVALID;
+#elif FOUNDATION_PLATFORM_APPLE
+	if (pollobj->fd_wakeup[0] >= 0) {
+		close(pollobj->fd_wakeup[0]);
+		close(pollobj->fd_wakeup[1]);
+	}
+	pollobj->fd_wakeup[0] = pollobj->fd_wakeup[1] = NETWORK_SOCKET_INVALID;
+#elif FOUNDATION_PLATFORM_WINDOWS
+	if (pollobj->fd_wakeup != NETWORK_SOCKET_INVALID)
+		_socket_close_fd(pollobj->fd_wakeup);
+	pollobj->fd_wakeup = NETWORK_SOCKET_INVALID;
+#endif
+}
+
+//Reset the wakeup descriptor, called on the poll thread when it signals readable
+static void
+network_poll_wakeup_drain(network_poll_t* pollobj) {
+	pollobj->flags |= NETWORK_POLLFLAG_WOKEN;
+	atomic_store32(&pollobj->wakeup, 0, memory_order_release);
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	uint64_t value;
+	ssize_t ret = read(pollobj->fd_wakeup, &value, sizeof(value));
+	FOUNDATION_UNUSED(ret);
+#elif FOUNDATION_PLATFORM_APPLE
+	char buffer[64];
+	while (read(pollobj->fd_wakeup[0], buffer, sizeof(buffer)) > 0) {
+	}
+#elif FOUNDATION_PLATFORM_WINDOWS
+	char buffer[64];
+	while (recv(pollobj->fd_wakeup, buffer, sizeof(buffer), 0) > 0) {
+	}
+#endif
+}
 
-#define network_poll_push_event(events, capacity, num, evt, sock) \
-	do { if ((num) < (capacity)) { \
-		(events)[(num)].event = (evt); \
-		(events)[(num)].socket = (sock); \
-		++(num); \
-	} } while (false)
+//Switch a newly initialized poll from the default backend, no sockets or descriptors added yet
+static bool
+network_poll_select_backend(network_poll_t* pollobj, network_poll_backend_t backend) {
+	switch (backend) {
+#if BUILD_ENABLE_NETWORK_IO_URING
+	case NETWORK_POLL_BACKEND_IO_URING:
+		pollobj->uring = network_poll_uring_allocate(NETWORK_POLL_URING_ENTRIES);
+		if (!pollobj->uring) {
+			int err = errno;
+			string_const_t errmsg = system_error_message(err);
+			log_warnf(HASH_NETWORK, WARNING_UNSUPPORTED,
+			          STRING_CONST("Network poll: io_uring unavailable: %.*s (%d)"),
+			          STRING_FORMAT(errmsg), err);
+			return false;
+		}
+		close(pollobj->fd_poll);
+		pollobj->fd_poll = -1;
+		network_poll_uring_arm_wakeup(pollobj);
+		break;
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	case NETWORK_POLL_BACKEND_POLL:
+		//Wakeup descriptor is polled in the extra entry of the poll array instead
+		close(pollobj->fd_poll);
+		pollobj->fd_poll = -1;
+		break;
+#endif
+	default:
+		return false;
+	}
+	pollobj->backend = backend;
+	return true;
+}
 
 network_poll_t*
 network_poll_allocate(unsigned int num_sockets) {
+	return network_poll_allocate_backend(num_sockets, NETWORK_POLL_BACKEND_DEFAULT);
+}
+
+network_poll_t*
+network_poll_allocate_backend(unsigned int num_sockets, network_poll_backend_t backend) {
 	network_poll_t* poll;
-	size_t memsize = sizeof(network_poll_t) +
-	                 sizeof(network_poll_slot_t) * num_sockets;
-#if FOUNDATION_PLATFORM_APPLE
-	memsize += sizeof(struct pollfd) * num_sockets;
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-	memsize += sizeof(struct epoll_event) * num_sockets;
-#endif
+	size_t memsize = sizeof(network_poll_t) + network_poll_storage_size(num_sockets);
 	poll = memory_allocate(HASH_NETWORK, memsize, 8, MEMORY_PERSISTENT);
 	network_poll_initialize(poll, num_sockets);
+	poll->flags |= NETWORK_POLLFLAG_GROWABLE;
+	if ((backend != NETWORK_POLL_BACKEND_DEFAULT) && (backend != poll->backend) &&
+	    !network_poll_select_backend(poll, backend)) {
+		log_warnf(HASH_NETWORK, WARNING_UNSUPPORTED,
+		          STRING_CONST("Network poll: Backend %d not supported, using default backend"), (int)backend);
+	}
 	return poll;
 }
 
 void
 network_poll_initialize(network_poll_t* pollobj, unsigned int num_sockets) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	pollobj->backend = NETWORK_POLL_BACKEND_EPOLL;
+#elif FOUNDATION_PLATFORM_POSIX
+	pollobj->backend = NETWORK_POLL_BACKEND_POLL;
+#else
+	pollobj->backend = NETWORK_POLL_BACKEND_SELECT;
+#endif
+	pollobj->flags = 0;
+	pollobj->busy_poll = 0;
+	memset(&pollobj->statistics, 0, sizeof(pollobj->statistics));
+	pollobj->waited = 0;
+	pollobj->returned = 0;
+	pollobj->watchdog = 0;
+	pollobj->stall_fn = nullptr;
+	pollobj->stall_context = nullptr;
 	pollobj->num_sockets = 0;
-	pollobj->max_sockets = num_sockets;
-#if FOUNDATION_PLATFORM_APPLE
-	pollobj->pollfds = pointer_offset(pollobj->slots, sizeof(network_poll_slot_t) * num_sockets);
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-	pollobj->events = pointer_offset(pollobj->slots, sizeof(network_poll_slot_t) * num_sockets);
-	pollobj->fd_poll = epoll_create((int)num_sockets);
+	pollobj->timers = nullptr;
+	pollobj->dispatch = nullptr;
+	pollobj->queue_lock = mutex_allocate(STRING_CONST("network_poll_queue"));
+	pollobj->queue = nullptr;
+	pollobj->pending = nullptr;
+	pollobj->pending_next = 0;
+	pollobj->sorted = nullptr;
+	pollobj->num_prioritized = 0;
+	pollobj->fds = nullptr;
+	pollobj->fd_table = nullptr;
+	pollobj->beacon = nullptr;
+	atomic_store32(&pollobj->queued, 0, memory_order_relaxed);
+	atomic_store32(&pollobj->wakeup, 0, memory_order_relaxed);
+	network_poll_set_storage(pollobj, pollobj->slotarr, num_sockets);
+#if FOUNDATION_PLATFORM_POSIX
+	pollobj->pollscratch = nullptr;
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	pollobj->fd_poll = epoll_create(num_sockets ? (int)num_sockets : 1);
+	pollobj->uring = nullptr;
+	pollobj->dirty = nullptr;
+	pollobj->removed = nullptr;
 #endif
+	network_poll_wakeup_initialize(pollobj);
 }
 
 void
 network_poll_finalize(network_poll_t* pollobj) {
+	network_poll_set_beacon(pollobj, nullptr);
+	network_poll_wakeup_finalize(pollobj);
+	for (size_t ireq = 0, rsize = array_size(pollobj->queue); ireq < rsize; ++ireq) {
+		if (pollobj->queue[ireq].sock->poll_queued == pollobj)
+			pollobj->queue[ireq].sock->poll_queued = nullptr;
+	}
+	mutex_deallocate(pollobj->queue_lock);
+	array_deallocate(pollobj->queue);
+	array_deallocate(pollobj->pending);
+	pollobj->pending_next = 0;
+	array_deallocate(pollobj->sorted);
+	pollobj->num_prioritized = 0;
+	for (size_t ifd = 0, fsize = array_size(pollobj->fds); ifd < fsize; ++ifd)
+		memory_deallocate(pollobj->fds[ifd]);
+	array_deallocate(pollobj->fds);
+	array_deallocate(pollobj->fd_table);
+#if FOUNDATION_PLATFORM_POSIX
+	array_deallocate(pollobj->pollscratch);
+#endif
+	pollobj->queue_lock = nullptr;
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-	close(pollobj->fd_poll);
-#else
-	FOUNDATION_UNUSED(pollobj);
+	if (pollobj->fd_poll >= 0)
+		close(pollobj->fd_poll);
+	array_deallocate(pollobj->dirty);
+	array_deallocate(pollobj->removed);
+#endif
+#if BUILD_ENABLE_NETWORK_IO_URING
+	network_poll_uring_deallocate(pollobj->uring);
+	pollobj->uring = nullptr;
+#endif
+	if (pollobj->slots != pollobj->slotarr)
+		memory_deallocate(pollobj->slots);
+	pollobj->slots = pollobj->slotarr;
+	_network_poll_timers_finalize(pollobj);
+}
+
+static bool
+network_poll_grow(network_poll_t* pollobj) {
+	void* storage;
+	size_t capacity;
+	network_poll_slot_t* slots;
+#if FOUNDATION_PLATFORM_POSIX
+	struct pollfd* pollfds;
+#endif
+	if (!(pollobj->flags & NETWORK_POLLFLAG_GROWABLE))
+		return false;
+
+	capacity = pollobj->max_sockets * 2;
+	if (capacity < NETWORK_POLL_MIN_GROW)
+		capacity = NETWORK_POLL_MIN_GROW;
+
+	log_debugf(HASH_NETWORK, STRING_CONST("Network poll: Growing capacity from %" PRIsize " to %" PRIsize " sockets"),
+	           pollobj->max_sockets, capacity);
+
+	//Registrations refer to the socket and slot indices are kept, only the storage moves
+	storage = memory_allocate(HASH_NETWORK, network_poll_storage_size(capacity), 8, MEMORY_PERSISTENT);
+	memcpy(storage, pollobj->slots, sizeof(network_poll_slot_t) * pollobj->num_sockets);
+	slots = pollobj->slots;
+#if FOUNDATION_PLATFORM_POSIX
+	pollfds = pollobj->pollfds;
+#endif
+	network_poll_set_storage(pollobj, storage, capacity);
+#if FOUNDATION_PLATFORM_POSIX
+	memcpy(pollobj->pollfds, pollfds, sizeof(struct pollfd) * pollobj->num_sockets);
 #endif
+	if (slots != pollobj->slotarr)
+		memory_deallocate(slots);
+
+	return true;
 }
 
 void
@@ -91,48 +455,220 @@ network_poll_sockets(network_poll_t* pollobj, socket_t** sockets, size_t max_soc
 }
 
 static void
-network_poll_update_slot(network_poll_t* pollobj, size_t slot, socket_t* sock) {
-#if FOUNDATION_PLATFORM_APPLE
+network_poll_update_slot(network_poll_t* pollobj, size_t slot, socket_t* sock);
+
+
+bool
+network_poll_edge_triggered(const network_poll_t* pollobj) {
+	return ((pollobj->flags & NETWORK_POLLFLAG_EDGE_TRIGGERED) != 0);
+}
+
+void
+network_poll_set_edge_triggered(network_poll_t* pollobj, bool edge_triggered) {
+	size_t islot;
+	unsigned int flags = (edge_triggered ?
+	                      pollobj->flags | NETWORK_POLLFLAG_EDGE_TRIGGERED :
+	                      pollobj->flags & ~NETWORK_POLLFLAG_EDGE_TRIGGERED);
+	if (flags == pollobj->flags)
+		return;
+	pollobj->flags = flags;
+	for (islot = 0; islot < pollobj->num_sockets; ++islot)
+		network_poll_update_slot(pollobj, islot, pollobj->slots[islot].sock);
+}
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+//Let the kernel busy poll the device queue on blocking reads and waits for the socket,
+//a zero budget clears it. Requires CAP_NET_ADMIN to exceed the system default, failure
+//only reduces the effect
+static void
+network_poll_busy_poll_fd(int fd, unsigned int busy_poll) {
+	int optval = (int)busy_poll;
+	int prefer = busy_poll ? 1 : 0;
+	if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &optval, sizeof(optval)) < 0) {
+		int err = NETWORK_SOCKET_ERROR;
+		log_debugf(HASH_NETWORK, STRING_CONST("Network poll: Unable to set busy poll on socket %d (%d)"),
+		           fd, err);
+		return;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+}
+
+#endif
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+static void
+network_poll_epoll_apply_slot(network_poll_t* pollobj, size_t slot, socket_t* sock) {
+	struct epoll_event event;
+	network_poll_slot_t* pslot = pollobj->slots + slot;
+	unsigned int mask = 0;
+	if (sock->fd != NETWORK_SOCKET_INVALID) {
+		mask = ((sock->state == SOCKETSTATE_CONNECTING) ? EPOLLOUT : EPOLLIN) | EPOLLERR | EPOLLHUP;
+		if (sock->state == SOCKETSTATE_CONNECTED)
+			mask |= EPOLLRDHUP;
+		if ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & NETWORK_POLL_WRITE_MASK))
+			mask |= EPOLLOUT;
+		if (pollobj->flags & NETWORK_POLLFLAG_EDGE_TRIGGERED)
+			mask |= EPOLLET;
+	}
+	//Registration already matches, nothing to change
+	if ((pslot->fd == sock->fd) && (pslot->mask == mask))
+		return;
+	if ((pslot->fd != sock->fd) && (pslot->fd != NETWORK_SOCKET_INVALID)) {
+		epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, pslot->fd, &event);
+		pslot->fd = NETWORK_SOCKET_INVALID;
+	}
+	if (sock->fd != NETWORK_SOCKET_INVALID) {
+		event.events = mask;
+		//Socket pointer is stable for the lifetime of the registration, slot index is not
+		event.data.ptr = sock;
+		if (pslot->fd == NETWORK_SOCKET_INVALID)
+			epoll_ctl(pollobj->fd_poll, EPOLL_CTL_ADD, sock->fd, &event);
+		//Descriptor was closed and reopened outside the poll, registration is gone
+		else if ((epoll_ctl(pollobj->fd_poll, EPOLL_CTL_MOD, sock->fd, &event) < 0) &&
+		         (errno == ENOENT))
+			epoll_ctl(pollobj->fd_poll, EPOLL_CTL_ADD, sock->fd, &event);
+	}
+	pslot->mask = mask;
+	pslot->fd = sock->fd;
+}
+
+#endif
+
+static void
+network_poll_apply_slot(network_poll_t* pollobj, size_t slot, socket_t* sock) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->busy_poll && (sock->fd != NETWORK_SOCKET_INVALID) &&
+	    (pollobj->slots[slot].fd != sock->fd))
+		network_poll_busy_poll_fd(sock->fd, pollobj->busy_poll);
+#endif
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring) {
+		network_poll_uring_update_slot(pollobj->uring, pollobj->slots + slot, sock);
+		pollobj->slots[slot].fd = sock->fd;
+		return;
+	}
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->backend == NETWORK_POLL_BACKEND_EPOLL) {
+		network_poll_epoll_apply_slot(pollobj, slot, sock);
+		return;
+	}
+#endif
+#if FOUNDATION_PLATFORM_POSIX
+	//Negative descriptors are ignored by poll, keeping the entry in place
 	if (sock->fd != NETWORK_SOCKET_INVALID) {
 		pollobj->pollfds[slot].fd = sock->fd;
 		pollobj->pollfds[slot].events = ((sock->state == SOCKETSTATE_CONNECTING) ? POLLOUT :
 		                                 POLLIN) | POLLERR | POLLHUP;
+		if (sock->state == SOCKETSTATE_CONNECTED)
+			pollobj->pollfds[slot].events |= POLLRDHUP;
+		if ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & NETWORK_POLL_WRITE_MASK))
+			pollobj->pollfds[slot].events |= POLLOUT;
 	}
 	else {
-		pollobj->pollfds[slot].fd = 0;
+		pollobj->pollfds[slot].fd = -1;
 		pollobj->pollfds[slot].events = 0;
 	}
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-	struct epoll_event event;
-	bool add = false;
-	if (pollobj->slots[slot].fd != sock->fd) {
-		add = true;
-		if (pollobj->slots[slot].fd != NETWORK_SOCKET_INVALID) {
-			epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, pollobj->slots[slot].fd, &event);
-			pollobj->slots[slot].fd = NETWORK_SOCKET_INVALID;
+	pollobj->pollfds[slot].revents = 0;
+#endif
+	pollobj->slots[slot].fd = sock->fd;
+}
+
+static void
+network_poll_update_slot(network_poll_t* pollobj, size_t slot, socket_t* sock) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->flags & NETWORK_POLLFLAG_DEFERRED) {
+		network_poll_slot_t* pslot = pollobj->slots + slot;
+		if (!pslot->dirty) {
+			array_push(pollobj->dirty, (unsigned int)slot);
+			pslot->dirty = (unsigned int)array_size(pollobj->dirty);
 		}
+		return;
 	}
-	if (sock->fd != NETWORK_SOCKET_INVALID) {
-		event.events = ((sock->state == SOCKETSTATE_CONNECTING) ? EPOLLOUT : EPOLLIN) |
-		               EPOLLERR | EPOLLHUP;
-		event.data.fd = (int)slot;
-		epoll_ctl(pollobj->fd_poll, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, sock->fd, &event);
+#endif
+	network_poll_apply_slot(pollobj, slot, sock);
+}
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+static void
+network_poll_apply_removed(network_poll_t* pollobj) {
+	size_t iremove, rsize;
+	for (iremove = 0, rsize = array_size(pollobj->removed); iremove < rsize; ++iremove) {
+		struct epoll_event event;
+		epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, pollobj->removed[iremove], &event);
 	}
+	array_clear(pollobj->removed);
+}
+
 #endif
-	pollobj->slots[slot].fd = sock->fd;
+
+static void
+network_poll_apply_changes(network_poll_t* pollobj) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	size_t ichange, csize;
+	network_poll_apply_removed(pollobj);
+	for (ichange = 0, csize = array_size(pollobj->dirty); ichange < csize; ++ichange) {
+		unsigned int islot = pollobj->dirty[ichange];
+		pollobj->slots[islot].dirty = 0;
+		network_poll_apply_slot(pollobj, islot, pollobj->slots[islot].sock);
+	}
+	array_clear(pollobj->dirty);
+#else
+	FOUNDATION_UNUSED(pollobj);
+#endif
+}
+
+bool
+network_poll_deferred(const network_poll_t* pollobj) {
+	return ((pollobj->flags & NETWORK_POLLFLAG_DEFERRED) != 0);
+}
+
+void
+network_poll_set_deferred(network_poll_t* pollobj, bool deferred) {
+	if (deferred) {
+		pollobj->flags |= NETWORK_POLLFLAG_DEFERRED;
+	}
+	else if (pollobj->flags & NETWORK_POLLFLAG_DEFERRED) {
+		pollobj->flags &= ~NETWORK_POLLFLAG_DEFERRED;
+		network_poll_apply_changes(pollobj);
+	}
 }
 
 bool
 network_poll_add_socket(network_poll_t* pollobj, socket_t* sock) {
 	size_t slot = pollobj->num_sockets;
-	if (slot < pollobj->max_sockets) {
+	if (sock->poll == pollobj)
+		return true;
+	if (sock->poll) {
+		log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
+		          STRING_CONST("Network poll: Socket (0x%" PRIfixPTR " : %d) already in another poll"),
+		          (uintptr_t)sock, sock->fd);
+		return false;
+	}
+	if ((slot < pollobj->max_sockets) || network_poll_grow(pollobj)) {
 		log_debugf(HASH_NETWORK, STRING_CONST("Network poll: Adding socket (0x%" PRIfixPTR " : %d)"),
 		           (uintptr_t)sock, sock->fd);
 
 		pollobj->slots[slot].sock = sock;
-		pollobj->slots[slot].fd = sock->fd;
+		pollobj->slots[slot].fd = NETWORK_SOCKET_INVALID;
+		pollobj->slots[slot].mask = 0;
+		pollobj->slots[slot].dirty = 0;
+		memset(pollobj->slots[slot].deadline, 0, sizeof(pollobj->slots[slot].deadline));
+		pollobj->slots[slot].priority = NETWORK_POLL_PRIORITY_NORMAL;
+		pollobj->slots[slot].handler = nullptr;
+		pollobj->slots[slot].context = nullptr;
+#if BUILD_ENABLE_NETWORK_IO_URING
+		pollobj->slots[slot].op = 0;
+		pollobj->slots[slot].io = 0;
+#endif
 		++pollobj->num_sockets;
 
+		sock->poll = pollobj;
+		sock->poll_slot = (unsigned int)slot;
+
 		network_poll_update_slot(pollobj, slot, sock);
 
 		return true;
@@ -142,233 +678,1355 @@ network_poll_add_socket(network_poll_t* pollobj, socket_t* sock) {
 
 void
 network_poll_update_socket(network_poll_t* pollobj, socket_t* sock) {
-	size_t islot, num_sockets = pollobj->num_sockets;
-	for (islot = 0; islot < num_sockets; ++islot) {
-		if (pollobj->slots[islot].sock == sock)
-			network_poll_update_slot(pollobj, islot, sock);
+	if (sock->poll == pollobj)
+		network_poll_update_slot(pollobj, sock->poll_slot, sock);
+}
+
+//Discard pending events of a socket leaving the poll, it may be deallocated. Send completions
+//hand a buffer back to the caller and are kept without the socket
+static void
+network_poll_pending_remove_socket(network_poll_t* pollobj, socket_t* sock) {
+	size_t ievt, inext, esize;
+	for (ievt = inext = pollobj->pending_next, esize = array_size(pollobj->pending); ievt < esize; ++ievt) {
+		if (pollobj->pending[ievt].socket != sock)
+			pollobj->pending[inext++] = pollobj->pending[ievt];
+		else if (pollobj->pending[ievt].event == NETWORKEVENT_SEND_COMPLETE) {
+			pollobj->pending[inext] = pollobj->pending[ievt];
+			pollobj->pending[inext++].socket = nullptr;
+		}
 	}
+	if (inext < esize)
+		array_resize(pollobj->pending, inext);
 }
 
 void
 network_poll_remove_socket(network_poll_t* pollobj, socket_t* sock) {
-	size_t islot, num_sockets = pollobj->num_sockets;
-	for (islot = 0; islot < num_sockets; ++islot) {
-		if (pollobj->slots[islot].sock == sock) {
+	size_t islot, ilast;
+	if (sock->poll != pollobj)
+		return;
+
+	islot = sock->poll_slot;
+	ilast = pollobj->num_sockets - 1;
+	FOUNDATION_ASSERT(pollobj->slots[islot].sock == sock);
+
+	log_debugf(HASH_NETWORK,
+	           STRING_CONST("Network poll: Removing socket (0x%" PRIfixPTR " : %d)"),
+	           (uintptr_t)sock, pollobj->slots[islot].fd);
+
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-			int fd_remove = pollobj->slots[islot].fd;
+	//Socket leaving the poll must not keep spinning in the kernel on its own reads
+	if (pollobj->busy_poll && (sock->fd != NETWORK_SOCKET_INVALID))
+		network_poll_busy_poll_fd(sock->fd, 0);
 #endif
-			log_debugf(HASH_NETWORK,
-			           STRING_CONST("Network poll: Removing socket (0x%" PRIfixPTR " : %d)"),
-			           (uintptr_t)pollobj->slots[islot].sock, pollobj->slots[islot].fd);
 
-			//Swap with last slot and erase
-			if (islot < pollobj->num_sockets - 1) {
-				memcpy(pollobj->slots + islot, pollobj->slots + (num_sockets - 1), sizeof(network_poll_slot_t));
-#if FOUNDATION_PLATFORM_APPLE
-				memcpy(pollobj->pollfds + islot, pollobj->pollfds + (num_sockets - 1), sizeof(struct pollfd));
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-				//Mod the moved socket
-				struct epoll_event event;
-				event.events = ((pollobj->slots[num_sockets - 1].sock->state == SOCKETSTATE_CONNECTING) ?
-				                EPOLLOUT : EPOLLIN) | EPOLLERR | EPOLLHUP;
-				event.data.fd = (int)islot;
-				epoll_ctl(pollobj->fd_poll, EPOLL_CTL_MOD, pollobj->slots[num_sockets - 1].fd, &event);
+	_network_poll_timers_remove_socket(pollobj, pollobj->slots + islot);
+	if (pollobj->dispatch)
+		_network_dispatch_remove_socket(pollobj->dispatch, sock);
+	network_poll_pending_remove_socket(pollobj, sock);
+	_network_poll_zerocopy_cancel(pollobj, sock, true);
+	if (pollobj->slots[islot].priority != NETWORK_POLL_PRIORITY_NORMAL)
+		--pollobj->num_prioritized;
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	//Drop pending change, a registration never applied needs no removal
+	if (pollobj->slots[islot].dirty) {
+		unsigned int ichange = pollobj->slots[islot].dirty - 1;
+		unsigned int ichangelast = (unsigned int)array_size(pollobj->dirty) - 1;
+		if (ichange < ichangelast) {
+			pollobj->dirty[ichange] = pollobj->dirty[ichangelast];
+			pollobj->slots[pollobj->dirty[ichange]].dirty = ichange + 1;
+		}
+		array_pop(pollobj->dirty);
+		pollobj->slots[islot].dirty = 0;
+	}
 #endif
-			}
-			memset(pollobj->slots + (num_sockets - 1), 0, sizeof(network_poll_slot_t));
-#if FOUNDATION_PLATFORM_APPLE
-			memset(pollobj->pollfds + (num_sockets - 1), 0, sizeof(struct pollfd));
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
-			struct epoll_event event;
-			epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, fd_remove, &event);
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring)
+		network_poll_uring_remove_slot(pollobj->uring, pollobj->slots + islot);
+	else
 #endif
-			num_sockets = --pollobj->num_sockets;
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if ((pollobj->backend == NETWORK_POLL_BACKEND_EPOLL) &&
+	    (pollobj->slots[islot].fd != NETWORK_SOCKET_INVALID)) {
+		if (pollobj->flags & NETWORK_POLLFLAG_DEFERRED) {
+			array_push(pollobj->removed, pollobj->slots[islot].fd);
+		}
+		else {
+			struct epoll_event event;
+			epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, pollobj->slots[islot].fd, &event);
 		}
 	}
-}
+#endif
 
-bool
-network_poll_has_socket(network_poll_t* pollobj, socket_t* sock) {
-	size_t islot, num_sockets;
-	num_sockets = pollobj->num_sockets;
-	for (islot = 0; islot < num_sockets; ++islot) {
-		if (pollobj->slots[islot].sock == sock)
-			return true;
+	//Swap with last slot and erase, registration data is the socket so no need to modify
+	if (islot < ilast) {
+		memcpy(pollobj->slots + islot, pollobj->slots + ilast, sizeof(network_poll_slot_t));
+#if FOUNDATION_PLATFORM_POSIX
+		memcpy(pollobj->pollfds + islot, pollobj->pollfds + ilast, sizeof(struct pollfd));
+#endif
+		pollobj->slots[islot].sock->poll_slot = (unsigned int)islot;
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+		if (pollobj->slots[islot].dirty)
+			pollobj->dirty[pollobj->slots[islot].dirty - 1] = (unsigned int)islot;
+#endif
 	}
-	return false;
+	memset(pollobj->slots + ilast, 0, sizeof(network_poll_slot_t));
+#if FOUNDATION_PLATFORM_POSIX
+	memset(pollobj->pollfds + ilast, 0, sizeof(struct pollfd));
+#endif
+	--pollobj->num_sockets;
+
+	sock->poll = nullptr;
+	sock->poll_slot = 0;
 }
 
-size_t
-network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
-             unsigned int timeoutms) {
-	int avail = 0;
-	size_t num_events = 0;
+void
+network_poll_set_write_interest(network_poll_t* pollobj, socket_t* sock, bool interest) {
+	if (interest == ((sock->flags & SOCKETFLAG_POLL_WRITE) != 0))
+		return;
+	sock->flags = (interest ?
+	               sock->flags | SOCKETFLAG_POLL_WRITE :
+	               sock->flags & ~SOCKETFLAG_POLL_WRITE);
+	network_poll_update_socket(pollobj, sock);
+}
 
-#if FOUNDATION_PLATFORM_WINDOWS
-	//TODO: Refactor to keep fd_set across loop and rebuild on change (add/remove)
-	int num_fd = 0;
-	int ret = 0;
-	size_t islot;
-	fd_set fdread, fdwrite, fderr;
-#endif
+bool
+network_poll_write_interest(const network_poll_t* pollobj, const socket_t* sock) {
+	return (sock->poll == pollobj) && ((sock->flags & SOCKETFLAG_POLL_WRITE) != 0);
+}
 
-	if (!pollobj->num_sockets)
-		return num_events;
+void
+network_poll_set_priority(network_poll_t* pollobj, socket_t* sock, network_poll_priority_t priority) {
+	network_poll_slot_t* slot;
+	if ((sock->poll != pollobj) || (priority >= NETWORK_POLL_PRIORITY_COUNT))
+		return;
+	slot = pollobj->slots + sock->poll_slot;
+	if (slot->priority == NETWORK_POLL_PRIORITY_NORMAL)
+		++pollobj->num_prioritized;
+	if (priority == NETWORK_POLL_PRIORITY_NORMAL)
+		--pollobj->num_prioritized;
+	slot->priority = priority;
+}
 
-#if FOUNDATION_PLATFORM_APPLE
+network_poll_priority_t
+network_poll_priority(const network_poll_t* pollobj, const socket_t* sock) {
+	if (sock->poll != pollobj)
+		return NETWORK_POLL_PRIORITY_NORMAL;
+	return (network_poll_priority_t)pollobj->slots[sock->poll_slot].priority;
+}
 
-	int ret = poll(pollobj->pollfds, (nfds_t)pollobj->num_sockets, (int)timeoutms);
+unsigned int
+_network_poll_event_priority(network_poll_t* pollobj, const network_poll_event_t* event) {
+	const socket_t* sock = event->socket;
+	if (sock && (sock->poll == pollobj))
+		return pollobj->slots[sock->poll_slot].priority;
+	return NETWORK_POLL_PRIORITY_NORMAL;
+}
 
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+network_poll_backend_t
+network_poll_backend(const network_poll_t* pollobj) {
+	return pollobj->backend;
+}
 
-	int ret = epoll_wait(pollobj->fd_poll, pollobj->events,
-	                     (int)pollobj->num_sockets + 1, (int)timeoutms);
-	int num_polled = ret;
+bool
+network_poll_submit_read(network_poll_t* pollobj, socket_t* sock, void* buffer, size_t size) {
+#if BUILD_ENABLE_NETWORK_IO_URING
+	return network_poll_uring_submit_io(pollobj, sock, NETWORK_POLL_URING_OP_READ, buffer, size);
+#else
+	FOUNDATION_UNUSED(pollobj);
+	FOUNDATION_UNUSED(sock);
+	FOUNDATION_UNUSED(buffer);
+	FOUNDATION_UNUSED(size);
+	return false;
+#endif
+}
 
-#elif FOUNDATION_PLATFORM_WINDOWS
+bool
+network_poll_submit_write(network_poll_t* pollobj, socket_t* sock, const void* buffer, size_t size) {
+#if BUILD_ENABLE_NETWORK_IO_URING
+	return network_poll_uring_submit_io(pollobj, sock, NETWORK_POLL_URING_OP_WRITE, (void*)buffer, size);
+#else
+	FOUNDATION_UNUSED(pollobj);
+	FOUNDATION_UNUSED(sock);
+	FOUNDATION_UNUSED(buffer);
+	FOUNDATION_UNUSED(size);
+	return false;
+#endif
+}
 
-	FD_ZERO(&fdread);
-	FD_ZERO(&fdwrite);
-	FD_ZERO(&fderr);
+bool
+network_poll_has_socket(network_poll_t* pollobj, socket_t* sock) {
+	return (sock->poll == pollobj);
+}
 
-	for (islot = 0; islot < pollobj->num_sockets; ++islot) {
-		int fd = pollobj->slots[islot].fd;
-		if (fd != NETWORK_SOCKET_INVALID) {
-			socket_t* sock = pollobj->slots[islot].sock;
+//Raw descriptors are found through an open addressed table of one-based indices into the
+//descriptor array, kept at most half full so probe sequences stay short
+static size_t
+network_poll_fd_home(const network_poll_t* pollobj, int fd) {
+	return ((uint32_t)fd * 2654435761U) & (array_size(pollobj->fd_table) - 1);
+}
 
-			FD_SET(fd, &fdread);
-			if (sock->state == SOCKETSTATE_CONNECTING)
-				FD_SET(fd, &fdwrite);
-			FD_SET(fd, &fderr);
+static size_t
+network_poll_fd_slot(const network_poll_t* pollobj, int fd) {
+	size_t mask = array_size(pollobj->fd_table) - 1;
+	size_t islot = network_poll_fd_home(pollobj, fd);
+	while (pollobj->fd_table[islot] && (pollobj->fds[pollobj->fd_table[islot] - 1]->fd != fd))
+		islot = (islot + 1) & mask;
+	return islot;
+}
 
-			if (fd >= num_fd)
-				num_fd = fd + 1;
+static void
+network_poll_fd_table_grow(network_poll_t* pollobj) {
+	size_t capacity = array_size(pollobj->fd_table) ? array_size(pollobj->fd_table) * 2 : 16;
+	size_t ifd, fsize;
+	array_resize(pollobj->fd_table, capacity);
+	memset(pollobj->fd_table, 0, sizeof(unsigned int) * capacity);
+	for (ifd = 0, fsize = array_size(pollobj->fds); ifd < fsize; ++ifd)
+		pollobj->fd_table[network_poll_fd_slot(pollobj, pollobj->fds[ifd]->fd)] = (unsigned int)ifd + 1;
+}
+
+static void
+network_poll_fd_table_erase(network_poll_t* pollobj, size_t islot) {
+	size_t mask = array_size(pollobj->fd_table) - 1;
+	size_t inext = islot;
+	//Move later entries of the probe sequence into the hole so lookups do not stop early
+	while (pollobj->fd_table[inext = (inext + 1) & mask]) {
+		size_t ihome = network_poll_fd_home(pollobj, pollobj->fds[pollobj->fd_table[inext] - 1]->fd);
+		if (((inext - ihome) & mask) >= ((inext - islot) & mask)) {
+			pollobj->fd_table[islot] = pollobj->fd_table[inext];
+			islot = inext;
 		}
 	}
+	pollobj->fd_table[islot] = 0;
+}
 
-	if (!num_fd) {
-		return num_events;
+static network_poll_fd_t*
+network_poll_find_fd(network_poll_t* pollobj, int fd, size_t* slot) {
+	size_t islot;
+	if (!array_size(pollobj->fd_table))
+		return nullptr;
+	islot = network_poll_fd_slot(pollobj, fd);
+	if (slot)
+		*slot = islot;
+	return pollobj->fd_table[islot] ? pollobj->fds[pollobj->fd_table[islot] - 1] : nullptr;
+}
+
+//Translate readiness of a raw descriptor to ready flags, errors and hangups are always reported
+static unsigned int
+network_poll_fd_ready(const network_poll_fd_t* entry, bool readable, bool writable, bool error,
+                      bool hangup) {
+	unsigned int ready = 0;
+	if (readable && (entry->mask & NETWORK_POLLFD_READ))
+		ready |= NETWORK_POLLFD_READ;
+	if (writable && (entry->mask & NETWORK_POLLFD_WRITE))
+		ready |= NETWORK_POLLFD_WRITE;
+	if (error)
+		ready |= NETWORK_POLLFD_ERROR;
+	if (hangup)
+		ready |= NETWORK_POLLFD_HANGUP;
+	return ready;
+}
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+static bool
+network_poll_apply_fd(network_poll_t* pollobj, network_poll_fd_t* entry, int op) {
+	struct epoll_event event;
+	event.events = EPOLLERR | EPOLLHUP;
+	if (entry->mask & NETWORK_POLLFD_READ)
+		event.events |= EPOLLIN;
+	if (entry->mask & NETWORK_POLLFD_WRITE)
+		event.events |= EPOLLOUT;
+	event.data.ptr = pointer_offset(entry, NETWORK_POLL_FD_TAG);
+	if (epoll_ctl(pollobj->fd_poll, op, entry->fd, &event) < 0) {
+		int err = NETWORK_SOCKET_ERROR;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Network poll: Unable to register descriptor %d: %.*s (%d)"),
+		          entry->fd, STRING_FORMAT(errmsg), err);
+		return false;
 	}
-	else {
-		struct timeval tv;
+	return true;
+}
 
-		tv.tv_sec  = timeoutms / 1000;
-		tv.tv_usec = (timeoutms % 1000) * 1000;
+#endif
 
-		ret = select(num_fd, &fdread, &fdwrite, &fderr,
-		             (timeoutms != NETWORK_TIMEOUT_INFINITE) ? &tv : nullptr);
+bool
+network_poll_add_fd(network_poll_t* pollobj, int fd, unsigned int mask, void* data) {
+	network_poll_fd_t* entry;
+	if ((fd == NETWORK_SOCKET_INVALID) || network_poll_find_fd(pollobj, fd, nullptr)) {
+		log_warnf(HASH_NETWORK, WARNING_INVALID_VALUE,
+		          STRING_CONST("Network poll: Descriptor %d invalid or already in poll"), fd);
+		return false;
 	}
 
-#else
-#  error Not implemented
+	entry = memory_allocate(HASH_NETWORK, sizeof(network_poll_fd_t), 8,
+	                        MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	entry->fd = fd;
+	entry->mask = mask;
+	entry->data = data;
+
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring)
+		network_poll_uring_update_fd(pollobj->uring, entry);
+	else
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->backend == NETWORK_POLL_BACKEND_EPOLL) {
+		//A pending removal of a closed socket may carry the same descriptor number, apply
+		//it before the registration so it cannot remove the new descriptor later
+		network_poll_apply_removed(pollobj);
+		if (!network_poll_apply_fd(pollobj, entry, EPOLL_CTL_ADD)) {
+			memory_deallocate(entry);
+			return false;
+		}
+	}
 #endif
 
-	if (ret < 0) {
-		int err = NETWORK_SOCKET_ERROR;
-		string_const_t errmsg = system_error_message(err);
-		log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS, STRING_CONST("Error in socket poll: %.*s (%d)"),
-		          STRING_FORMAT(errmsg), err);
-		if (!avail)
-			return num_events;
-		ret = avail;
+	array_push(pollobj->fds, entry);
+	if (array_size(pollobj->fds) * 2 > array_size(pollobj->fd_table))
+		network_poll_fd_table_grow(pollobj);
+	else
+		pollobj->fd_table[network_poll_fd_slot(pollobj, fd)] = (unsigned int)array_size(pollobj->fds);
+	return true;
+}
+
+bool
+network_poll_update_fd(network_poll_t* pollobj, int fd, unsigned int mask) {
+	network_poll_fd_t* entry = network_poll_find_fd(pollobj, fd, nullptr);
+	if (!entry)
+		return false;
+	if (entry->mask == mask)
+		return true;
+	entry->mask = mask;
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring) {
+		network_poll_uring_update_fd(pollobj->uring, entry);
+		return true;
 	}
-	if (!avail && !ret)
-		return num_events;
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->backend == NETWORK_POLL_BACKEND_EPOLL)
+		return network_poll_apply_fd(pollobj, entry, EPOLL_CTL_MOD);
+#endif
+	return true;
+}
 
-#if FOUNDATION_PLATFORM_APPLE
+void
+network_poll_remove_fd(network_poll_t* pollobj, int fd) {
+	size_t islot, index, ilast, ievt, inext, esize;
+	network_poll_fd_t* entry = network_poll_find_fd(pollobj, fd, &islot);
+	if (!entry)
+		return;
 
-	struct pollfd* pfd = pollobj->pollfds;
-	network_poll_slot_t* slot = pollobj->slots;
-	for (size_t islot = 0; islot < pollobj->num_sockets; ++islot, ++pfd, ++slot) {
-		socket_t* sock = slot->sock;
-		bool update_slot = false;
-		bool had_error = false;
-		if (pfd->revents & POLLERR) {
-			update_slot = true;
-			had_error = true;
-			network_poll_push_event(events, capacity, num_events, NETWORKEVENT_ERROR, sock);
-			socket_close(sock);
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring)
+		network_poll_uring_remove_fd(pollobj->uring, entry);
+	else
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->backend == NETWORK_POLL_BACKEND_EPOLL) {
+		struct epoll_event event;
+		epoll_ctl(pollobj->fd_poll, EPOLL_CTL_DEL, fd, &event);
+	}
+#endif
+
+	//Discard pending events carrying the user data of the descriptor
+	for (ievt = inext = pollobj->pending_next, esize = array_size(pollobj->pending); ievt < esize; ++ievt) {
+		const network_poll_event_t* event = pollobj->pending + ievt;
+		if ((event->event != NETWORKEVENT_FD) || (event->buffer != entry->data))
+			pollobj->pending[inext++] = *event;
+	}
+	if (inext < esize)
+		array_resize(pollobj->pending, inext);
+
+	//Last descriptor is moved into the erased position
+	index = pollobj->fd_table[islot] - 1;
+	ilast = array_size(pollobj->fds) - 1;
+	network_poll_fd_table_erase(pollobj, islot);
+	if (index < ilast)
+		pollobj->fd_table[network_poll_fd_slot(pollobj, pollobj->fds[ilast]->fd)] = (unsigned int)index + 1;
+	array_erase(pollobj->fds, index);
+	memory_deallocate(entry);
+}
+
+size_t
+network_poll_num_fds(network_poll_t* pollobj) {
+	return array_size(pollobj->fds);
+}
+
+unsigned int
+network_poll_busy_poll(const network_poll_t* pollobj) {
+	return pollobj->busy_poll;
+}
+
+void
+network_poll_set_busy_poll(network_poll_t* pollobj, unsigned int budgetus) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	size_t islot;
+	if (budgetus != pollobj->busy_poll) {
+		for (islot = 0; islot < pollobj->num_sockets; ++islot) {
+			if (pollobj->slots[islot].fd != NETWORK_SOCKET_INVALID)
+				network_poll_busy_poll_fd(pollobj->slots[islot].fd, budgetus);
 		}
-		if (pfd->revents & POLLHUP) {
-			update_slot = true;
-			had_error = true;
-			network_poll_push_event(events, capacity, num_events, NETWORKEVENT_HANGUP, sock);
-			socket_close(sock);
+	}
+#endif
+	pollobj->busy_poll = budgetus;
+}
+
+network_poll_statistics_t
+network_poll_statistics(const network_poll_t* pollobj) {
+	return pollobj->statistics;
+}
+
+void
+network_poll_reset_statistics(network_poll_t* pollobj) {
+	memset(&pollobj->statistics, 0, sizeof(pollobj->statistics));
+}
+
+bool
+network_poll_instrumented(const network_poll_t* pollobj) {
+	return ((pollobj->flags & NETWORK_POLLFLAG_INSTRUMENTED) != 0);
+}
+
+void
+network_poll_set_instrumented(network_poll_t* pollobj, bool instrumented) {
+	if (instrumented)
+		pollobj->flags |= NETWORK_POLLFLAG_INSTRUMENTED;
+	else
+		pollobj->flags &= ~(unsigned int)NETWORK_POLLFLAG_INSTRUMENTED;
+	pollobj->returned = 0;
+}
+
+void
+network_poll_set_watchdog(network_poll_t* pollobj, unsigned int thresholdus, network_poll_stall_fn fn,
+                          void* context) {
+	pollobj->watchdog = thresholdus;
+	pollobj->stall_fn = fn;
+	pollobj->stall_context = context;
+	pollobj->returned = 0;
+}
+
+void
+_network_poll_histogram_record(network_poll_histogram_t* histogram, uint64_t value) {
+	unsigned int ibucket = 0;
+	uint64_t bound = value;
+	while (bound && (ibucket < NETWORK_POLL_HISTOGRAM_BUCKETS - 1)) {
+		bound >>= 1;
+		++ibucket;
+	}
+	++histogram->bucket[ibucket];
+	++histogram->count;
+	histogram->sum += value;
+	if (value > histogram->max)
+		histogram->max = value;
+}
+
+uint64_t
+_network_poll_ticks_to_us(tick_t ticks) {
+	return (uint64_t)((ticks * 1000000LL) / time_ticks_per_second());
+}
+
+uint64_t
+network_poll_histogram_percentile(const network_poll_histogram_t* histogram, real percentile) {
+	uint64_t cumulative = 0;
+	real rank = (real)histogram->count * percentile;
+	unsigned int ibucket;
+	for (ibucket = 0; ibucket < NETWORK_POLL_HISTOGRAM_BUCKETS; ++ibucket) {
+		cumulative += histogram->bucket[ibucket];
+		if (cumulative && ((real)cumulative >= rank)) {
+			uint64_t bound = ibucket ? ((1ULL << ibucket) - 1) : 0;
+			return (bound < histogram->max) ? bound : histogram->max;
 		}
-		if (!had_error && (pfd->revents & POLLIN)) {
-			if (sock->state == SOCKETSTATE_LISTENING) {
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_CONNECTION, sock);
-			}
-			else {
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_DATAIN, sock);
+	}
+	return histogram->max;
+}
+
+//Record time outside the poll since the previous call returned, and report stalls
+static void
+network_poll_check_gap(network_poll_t* pollobj) {
+	uint64_t gap = _network_poll_ticks_to_us(time_elapsed_ticks(pollobj->returned));
+	if (pollobj->flags & NETWORK_POLLFLAG_INSTRUMENTED)
+		_network_poll_histogram_record(&pollobj->statistics.gap, gap);
+	if (pollobj->watchdog && (gap > pollobj->watchdog)) {
+		++pollobj->statistics.stalls;
+		if (pollobj->stall_fn)
+			pollobj->stall_fn(pollobj, gap, pollobj->stall_context);
+		else
+			log_warnf(HASH_NETWORK, WARNING_PERFORMANCE,
+			          STRING_CONST("Network poll: Event loop stalled for %" PRIu64 "us between polls (threshold %uus)"),
+			          gap, pollobj->watchdog);
+	}
+}
+
+//Mark the end of the backend wait system call, separating wait and processing time
+static void
+network_poll_mark_waited(network_poll_t* pollobj) {
+	if (pollobj->flags & NETWORK_POLLFLAG_INSTRUMENTED)
+		pollobj->waited = time_current();
+}
+
+void
+network_poll_wakeup(network_poll_t* pollobj) {
+	//Only the first wakeup since the poll thread last drained the descriptor signals it
+	if (!atomic_cas32(&pollobj->wakeup, 1, 0, memory_order_acq_rel, memory_order_acquire))
+		return;
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	uint64_t value = 1;
+	ssize_t ret = write(pollobj->fd_wakeup, &value, sizeof(value));
+	FOUNDATION_UNUSED(ret);
+#elif FOUNDATION_PLATFORM_APPLE
+	char value = 1;
+	ssize_t ret = write(pollobj->fd_wakeup[1], &value, 1);
+	FOUNDATION_UNUSED(ret);
+#elif FOUNDATION_PLATFORM_WINDOWS
+	char value = 1;
+	send(pollobj->fd_wakeup, &value, 1, 0);
+#endif
+}
+
+static void
+network_poll_queue_request(network_poll_t* pollobj, socket_t* sock, int op) {
+	network_poll_request_t request;
+	request.sock = sock;
+	request.op = op;
+	mutex_lock(pollobj->queue_lock);
+	sock->poll_queued = pollobj;
+	array_push(pollobj->queue, request);
+	atomic_store32(&pollobj->queued, (int32_t)array_size(pollobj->queue), memory_order_release);
+	mutex_unlock(pollobj->queue_lock);
+	network_poll_wakeup(pollobj);
+}
+
+void
+network_poll_queue_add_socket(network_poll_t* pollobj, socket_t* sock) {
+	network_poll_queue_request(pollobj, sock, NETWORK_POLL_REQUEST_ADD);
+}
+
+void
+network_poll_queue_remove_socket(network_poll_t* pollobj, socket_t* sock) {
+	network_poll_queue_request(pollobj, sock, NETWORK_POLL_REQUEST_REMOVE);
+}
+
+size_t
+network_poll_num_queued(network_poll_t* pollobj) {
+	return (size_t)atomic_load32(&pollobj->queued, memory_order_acquire);
+}
+
+void
+_network_poll_apply_queue(network_poll_t* pollobj) {
+	size_t ireq, rsize;
+	mutex_lock(pollobj->queue_lock);
+	for (ireq = 0, rsize = array_size(pollobj->queue); ireq < rsize; ++ireq) {
+		socket_t* sock = pollobj->queue[ireq].sock;
+		if (sock->poll_queued == pollobj)
+			sock->poll_queued = nullptr;
+		if (pollobj->queue[ireq].op == NETWORK_POLL_REQUEST_REMOVE) {
+			network_poll_remove_socket(pollobj, sock);
+		}
+		else if (!network_poll_add_socket(pollobj, sock)) {
+			log_warnf(HASH_NETWORK, WARNING_RESOURCE,
+			          STRING_CONST("Network poll: Unable to add queued socket (0x%" PRIfixPTR " : %d)"),
+			          (uintptr_t)sock, sock->fd);
+		}
+	}
+	array_clear(pollobj->queue);
+	atomic_store32(&pollobj->queued, 0, memory_order_release);
+	mutex_unlock(pollobj->queue_lock);
+}
+
+void
+_network_poll_queue_purge(network_poll_t* pollobj, socket_t* sock) {
+	size_t ireq, ikeep, rsize;
+	mutex_lock(pollobj->queue_lock);
+	for (ireq = ikeep = 0, rsize = array_size(pollobj->queue); ireq < rsize; ++ireq) {
+		if (pollobj->queue[ireq].sock != sock)
+			pollobj->queue[ikeep++] = pollobj->queue[ireq];
+	}
+	if (ikeep < rsize) {
+		array_resize(pollobj->queue, ikeep);
+		atomic_store32(&pollobj->queued, (int32_t)ikeep, memory_order_release);
+	}
+	if (sock->poll_queued == pollobj)
+		sock->poll_queued = nullptr;
+	mutex_unlock(pollobj->queue_lock);
+}
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+//Deliver zero-copy send completions queued on the socket error queue. Completions of a TCP
+//socket arrive in send order, so a range completes all pending sends up to its last send
+static void
+network_poll_zerocopy_reap(network_poll_t* pollobj, socket_t* sock, network_poll_event_t* events,
+                           size_t capacity, size_t* num_events) {
+	char control[128];
+	struct msghdr msg;
+	struct cmsghdr* cmsg;
+	size_t num_done = 0;
+	size_t num_pending = array_size(sock->zerocopy);
+
+	while (num_done < num_pending) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (recvmsg(sock->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+			break;
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			const struct sock_extended_err* serr = (const struct sock_extended_err*)(void*)CMSG_DATA(cmsg);
+			if (!(((cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR)) ||
+			      ((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR))) ||
+			    (serr->ee_errno != 0) || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+				continue;
+			//Range is [ee_info, ee_data] of wrapping sequence numbers
+			while ((num_done < num_pending) && ((int32_t)(sock->zerocopy[num_done].last - serr->ee_data) <= 0)) {
+				const socket_zerocopy_t* done = sock->zerocopy + num_done++;
+				network_poll_push_completion(pollobj, events, capacity, *num_events, NETWORKEVENT_SEND_COMPLETE,
+				                             sock, (void*)(uintptr_t)done->buffer,
+				                             (done->size < INT32_MAX) ? (int)done->size : INT32_MAX);
 			}
 		}
-		if (!had_error && (sock->state == SOCKETSTATE_CONNECTING) && (pfd->revents & POLLOUT)) {
+	}
+
+	if (num_done) {
+		memmove(sock->zerocopy, sock->zerocopy + num_done, sizeof(socket_zerocopy_t) * (num_pending - num_done));
+		array_resize(sock->zerocopy, num_pending - num_done);
+	}
+}
+
+#endif
+
+#if FOUNDATION_PLATFORM_POSIX
+
+//Translate readiness of a polled socket to events, returns true if the slot needs updating
+static bool
+network_poll_process_socket(network_poll_t* pollobj, socket_t* sock, bool readable, bool writable,
+                            bool error, bool hangup, bool peer_closed, network_poll_event_t* events,
+                            size_t capacity, size_t* num_events) {
+	bool update_slot = false;
+	bool had_error = false;
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	//Error queue readiness signals zero-copy completions, only an error if the socket has one
+	if ((error || hangup) && array_size(sock->zerocopy)) {
+		network_poll_zerocopy_reap(pollobj, sock, events, capacity, num_events);
+		if (error && !hangup) {
 			int serr = 0;
 			socklen_t slen = sizeof(int);
 			getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
-			if (!serr) {
-				sock->state = SOCKETSTATE_CONNECTED;
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_CONNECTED, sock);
-			}
-			else {
-				had_error = true;
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_ERROR, sock);
-				socket_close(sock);
+			error = (serr != 0);
+		}
+	}
+#endif
+	//Peer shut down its side, data still unread is returned before the socket closes
+	if (peer_closed && !error && !hangup && (sock->state == SOCKETSTATE_CONNECTED)) {
+		update_slot = true;
+		if (_socket_available_fd(sock->fd) > 0)
+			sock->state = SOCKETSTATE_DISCONNECTED;
+		else
+			hangup = true;
+	}
+	if (error) {
+		update_slot = true;
+		had_error = true;
+		network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_ERROR, sock);
+		socket_close(sock);
+	}
+	if (hangup) {
+		update_slot = true;
+		had_error = true;
+		network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_HANGUP, sock);
+		socket_close(sock);
+	}
+	if (!had_error && readable) {
+		sock->flags &= ~SOCKETFLAG_DRAINED;
+		if (sock->state == SOCKETSTATE_LISTENING) {
+			network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_CONNECTION, sock);
+		}
+		else {
+			network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_DATAIN, sock);
+		}
+	}
+	if (!had_error && (sock->state == SOCKETSTATE_CONNECTED) &&
+	    (sock->flags & NETWORK_POLL_WRITE_MASK) && writable) {
+		if (sock->flags & SOCKETFLAG_OUTPUT_QUEUED)
+			update_slot = network_poll_flush_output(pollobj, sock, events, capacity, num_events);
+		if ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & SOCKETFLAG_POLL_WRITE))
+			network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_DATAOUT, sock);
+	}
+	else if (!had_error && (sock->state == SOCKETSTATE_CONNECTING) && writable) {
+		int serr = 0;
+		socklen_t slen = sizeof(int);
+		getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
+		if (!serr) {
+			sock->state = SOCKETSTATE_CONNECTED;
+			network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_CONNECTED, sock);
+		}
+		else {
+			network_poll_push_event(pollobj, events, capacity, *num_events, NETWORKEVENT_ERROR, sock);
+			socket_close(sock);
+		}
+		update_slot = true;
+	}
+	return update_slot;
+}
+
+#endif
+
+#if BUILD_ENABLE_NETWORK_IO_URING
+
+typedef struct network_poll_uring_op_t {
+	//Null if the socket was removed from the poll while the operation was in flight
+	socket_t* sock;
+	void* buffer;
+	unsigned int type;
+	unsigned int mask;
+	unsigned int next_free;
+} network_poll_uring_op_t;
+
+struct network_poll_uring_t {
+	int fd;
+	unsigned int sq_entries;
+	unsigned int sq_queued;
+	unsigned int* sq_head;
+	unsigned int* sq_tail;
+	unsigned int* sq_mask;
+	unsigned int* sq_array;
+	struct io_uring_sqe* sqes;
+	unsigned int* cq_head;
+	unsigned int* cq_tail;
+	unsigned int* cq_mask;
+	struct io_uring_cqe* cqes;
+	void* sq_ring;
+	size_t sq_ring_size;
+	void* cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+	//Operation records, user data of an operation is the one-based record index
+	network_poll_uring_op_t* ops;
+	unsigned int op_free;
+	//Poll registrations that could not be queued on a full ring, armed again on next wait
+	bool rearm;
+	bool rearm_wakeup;
+	//Referenced by a queued timeout until the ring is entered, must outlive the wait call
+	struct __kernel_timespec timeout;
+};
+
+static network_poll_uring_t*
+network_poll_uring_allocate(unsigned int entries) {
+	network_poll_uring_t* uring;
+	struct io_uring_params params;
+	int fd;
+
+	memset(&params, 0, sizeof(params));
+	fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0)
+		return nullptr;
+
+	uring = memory_allocate(HASH_NETWORK, sizeof(network_poll_uring_t), 0,
+	                        MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	uring->fd = fd;
+	uring->sq_entries = params.sq_entries;
+	uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (uring->cq_ring_size > uring->sq_ring_size)
+			uring->sq_ring_size = uring->cq_ring_size;
+		uring->cq_ring_size = uring->sq_ring_size;
+	}
+
+	uring->sq_ring = mmap(0, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                      fd, IORING_OFF_SQ_RING);
+	if (uring->sq_ring == MAP_FAILED)
+		goto failed;
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		uring->cq_ring = uring->sq_ring;
+	}
+	else {
+		uring->cq_ring = mmap(0, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		                      fd, IORING_OFF_CQ_RING);
+		if (uring->cq_ring == MAP_FAILED)
+			goto failed;
+	}
+	uring->sqes = mmap(0, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                   fd, IORING_OFF_SQES);
+	if (uring->sqes == MAP_FAILED)
+		goto failed;
+
+	uring->sq_head = pointer_offset(uring->sq_ring, params.sq_off.head);
+	uring->sq_tail = pointer_offset(uring->sq_ring, params.sq_off.tail);
+	uring->sq_mask = pointer_offset(uring->sq_ring, params.sq_off.ring_mask);
+	uring->sq_array = pointer_offset(uring->sq_ring, params.sq_off.array);
+	uring->cq_head = pointer_offset(uring->cq_ring, params.cq_off.head);
+	uring->cq_tail = pointer_offset(uring->cq_ring, params.cq_off.tail);
+	uring->cq_mask = pointer_offset(uring->cq_ring, params.cq_off.ring_mask);
+	uring->cqes = pointer_offset(uring->cq_ring, params.cq_off.cqes);
+
+	return uring;
+
+failed:
+	if (uring->sqes && (uring->sqes != MAP_FAILED))
+		munmap(uring->sqes, uring->sqes_size);
+	if (uring->cq_ring && (uring->cq_ring != MAP_FAILED) && (uring->cq_ring != uring->sq_ring))
+		munmap(uring->cq_ring, uring->cq_ring_size);
+	if (uring->sq_ring != MAP_FAILED)
+		munmap(uring->sq_ring, uring->sq_ring_size);
+	close(fd);
+	memory_deallocate(uring);
+	return nullptr;
+}
+
+static void
+network_poll_uring_deallocate(network_poll_uring_t* uring) {
+	if (!uring)
+		return;
+	//Closing the ring cancels all operations in flight
+	munmap(uring->sqes, uring->sqes_size);
+	if (uring->cq_ring != uring->sq_ring)
+		munmap(uring->cq_ring, uring->cq_ring_size);
+	munmap(uring->sq_ring, uring->sq_ring_size);
+	close(uring->fd);
+	array_deallocate(uring->ops);
+	memory_deallocate(uring);
+}
+
+static int
+network_poll_uring_enter(network_poll_uring_t* uring, unsigned int min_complete) {
+	unsigned int flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+	int ret = (int)syscall(__NR_io_uring_enter, uring->fd, uring->sq_queued, min_complete, flags, 0, 0);
+	if (ret >= 0) {
+		uring->sq_queued -= ((unsigned int)ret < uring->sq_queued) ? (unsigned int)ret : uring->sq_queued;
+	}
+	else if (errno != EINTR) {
+		int err = errno;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL, STRING_CONST("Error in io_uring enter: %.*s (%d)"),
+		          STRING_FORMAT(errmsg), err);
+	}
+	return ret;
+}
+
+static struct io_uring_sqe*
+network_poll_uring_sqe(network_poll_uring_t* uring, uint64_t user_data) {
+	struct io_uring_sqe* sqe;
+	unsigned int tail = *uring->sq_tail;
+	unsigned int index;
+	//Submit queued entries to make room when the submission ring is full
+	if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries) {
+		network_poll_uring_enter(uring, 0);
+		//Submission failed, the oldest entry is still unsubmitted and must not be overwritten
+		if (tail - __atomic_load_n(uring->sq_head, __ATOMIC_ACQUIRE) >= uring->sq_entries)
+			return nullptr;
+	}
+	index = tail & *uring->sq_mask;
+	sqe = uring->sqes + index;
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->user_data = user_data;
+	uring->sq_array[index] = index;
+	__atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++uring->sq_queued;
+	return sqe;
+}
+
+static unsigned int
+network_poll_uring_op_allocate(network_poll_uring_t* uring, socket_t* sock, unsigned int type) {
+	network_poll_uring_op_t* op;
+	unsigned int index = uring->op_free;
+	if (index != NETWORK_POLL_URING_OP_NONE) {
+		uring->op_free = uring->ops[index - 1].next_free;
+	}
+	else {
+		network_poll_uring_op_t newop;
+		memset(&newop, 0, sizeof(newop));
+		array_push(uring->ops, newop);
+		index = (unsigned int)array_size(uring->ops);
+	}
+	op = uring->ops + (index - 1);
+	op->sock = sock;
+	op->buffer = nullptr;
+	op->type = type;
+	op->mask = 0;
+	op->next_free = NETWORK_POLL_URING_OP_NONE;
+	return index;
+}
+
+static void
+network_poll_uring_op_deallocate(network_poll_uring_t* uring, unsigned int index) {
+	uring->ops[index - 1].sock = nullptr;
+	uring->ops[index - 1].next_free = uring->op_free;
+	uring->op_free = index;
+}
+
+static void
+network_poll_uring_arm_wakeup(network_poll_t* pollobj) {
+	struct io_uring_sqe* sqe;
+	if (pollobj->fd_wakeup < 0)
+		return;
+	sqe = network_poll_uring_sqe(pollobj->uring, NETWORK_POLL_URING_WAKEUP);
+	pollobj->uring->rearm_wakeup = !sqe;
+	if (!sqe)
+		return;
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = pollobj->fd_wakeup;
+	sqe->poll_events = POLLIN;
+}
+
+static unsigned int
+network_poll_uring_mask(const socket_t* sock) {
+	unsigned int mask;
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return 0;
+	mask = ((sock->state == SOCKETSTATE_CONNECTING) ? POLLOUT : POLLIN) | POLLERR | POLLHUP;
+	if (sock->state == SOCKETSTATE_CONNECTED)
+		mask |= POLLRDHUP;
+	if ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & NETWORK_POLL_WRITE_MASK))
+		mask |= POLLOUT;
+	return mask;
+}
+
+static void
+network_poll_uring_disarm(network_poll_uring_t* uring, network_poll_slot_t* slot) {
+	struct io_uring_sqe* sqe;
+	if (slot->op == NETWORK_POLL_URING_OP_NONE)
+		return;
+	//Orphan the record, it is released when the cancelled poll completes
+	uring->ops[slot->op - 1].sock = nullptr;
+	sqe = network_poll_uring_sqe(uring, NETWORK_POLL_URING_IGNORE);
+	if (sqe) {
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = slot->op;
+	}
+	slot->op = NETWORK_POLL_URING_OP_NONE;
+}
+
+//Poll operations are one-shot, re-armed with the current mask after each completion
+static void
+network_poll_uring_update_slot(network_poll_uring_t* uring, network_poll_slot_t* slot, socket_t* sock) {
+	struct io_uring_sqe* sqe;
+	unsigned int mask = network_poll_uring_mask(sock);
+	if ((slot->op != NETWORK_POLL_URING_OP_NONE) &&
+	    ((slot->fd != sock->fd) || (uring->ops[slot->op - 1].mask != mask)))
+		network_poll_uring_disarm(uring, slot);
+	if (!mask || (slot->op != NETWORK_POLL_URING_OP_NONE))
+		return;
+	slot->op = network_poll_uring_op_allocate(uring, sock, NETWORK_POLL_URING_OP_POLL);
+	uring->ops[slot->op - 1].mask = mask;
+	sqe = network_poll_uring_sqe(uring, slot->op);
+	if (!sqe) {
+		network_poll_uring_op_deallocate(uring, slot->op);
+		slot->op = NETWORK_POLL_URING_OP_NONE;
+		uring->rearm = true;
+		return;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = sock->fd;
+	sqe->poll_events = (uint16_t)mask;
+}
+
+static void
+network_poll_uring_remove_slot(network_poll_uring_t* uring, network_poll_slot_t* slot) {
+	size_t iop, opsize;
+	network_poll_uring_disarm(uring, slot);
+	if (!slot->io)
+		return;
+	//Cancel reads and writes in flight, completions are reported without socket
+	for (iop = 0, opsize = array_size(uring->ops); iop < opsize; ++iop) {
+		network_poll_uring_op_t* op = uring->ops + iop;
+		if ((op->sock == slot->sock) && (op->type != NETWORK_POLL_URING_OP_POLL)) {
+			struct io_uring_sqe* sqe = network_poll_uring_sqe(uring, NETWORK_POLL_URING_IGNORE);
+			if (sqe) {
+				sqe->opcode = IORING_OP_ASYNC_CANCEL;
+				sqe->fd = -1;
+				sqe->addr = iop + 1;
 			}
-			update_slot = true;
+			op->sock = nullptr;
 		}
-		if (update_slot)
-			network_poll_update_slot(pollobj, islot, sock);
 	}
+	slot->io = 0;
+}
+
+static void
+network_poll_uring_remove_fd(network_poll_uring_t* uring, network_poll_fd_t* entry) {
+	struct io_uring_sqe* sqe;
+	if (entry->op == NETWORK_POLL_URING_OP_NONE)
+		return;
+	//Orphan the record, it is released when the cancelled poll completes
+	uring->ops[entry->op - 1].buffer = nullptr;
+	sqe = network_poll_uring_sqe(uring, NETWORK_POLL_URING_IGNORE);
+	if (sqe) {
+		sqe->opcode = IORING_OP_POLL_REMOVE;
+		sqe->fd = -1;
+		sqe->addr = entry->op;
+	}
+	entry->op = NETWORK_POLL_URING_OP_NONE;
+}
+
+static void
+network_poll_uring_update_fd(network_poll_uring_t* uring, network_poll_fd_t* entry) {
+	struct io_uring_sqe* sqe;
+	unsigned int mask = POLLERR | POLLHUP;
+	if (entry->mask & NETWORK_POLLFD_READ)
+		mask |= POLLIN;
+	if (entry->mask & NETWORK_POLLFD_WRITE)
+		mask |= POLLOUT;
+	network_poll_uring_remove_fd(uring, entry);
+	entry->op = network_poll_uring_op_allocate(uring, nullptr, NETWORK_POLL_URING_OP_FD);
+	uring->ops[entry->op - 1].buffer = entry;
+	uring->ops[entry->op - 1].mask = mask;
+	sqe = network_poll_uring_sqe(uring, entry->op);
+	if (!sqe) {
+		network_poll_uring_op_deallocate(uring, entry->op);
+		entry->op = NETWORK_POLL_URING_OP_NONE;
+		uring->rearm = true;
+		return;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = entry->fd;
+	sqe->poll_events = (uint16_t)mask;
+}
+
+static void
+network_poll_uring_rearm(network_poll_t* pollobj) {
+	network_poll_uring_t* uring = pollobj->uring;
+	size_t islot, ifd;
+	if (uring->rearm_wakeup)
+		network_poll_uring_arm_wakeup(pollobj);
+	if (!uring->rearm)
+		return;
+	uring->rearm = false;
+	for (islot = 0; islot < pollobj->num_sockets; ++islot) {
+		network_poll_slot_t* slot = pollobj->slots + islot;
+		if (slot->op == NETWORK_POLL_URING_OP_NONE)
+			network_poll_uring_update_slot(uring, slot, slot->sock);
+	}
+	for (ifd = 0; ifd < array_size(pollobj->fds); ++ifd) {
+		if (pollobj->fds[ifd]->op == NETWORK_POLL_URING_OP_NONE)
+			network_poll_uring_update_fd(uring, pollobj->fds[ifd]);
+	}
+}
+
+static bool
+network_poll_uring_submit_io(network_poll_t* pollobj, socket_t* sock, unsigned int type,
+                             void* buffer, size_t size) {
+	network_poll_uring_t* uring = pollobj->uring;
+	struct io_uring_sqe* sqe;
+	unsigned int index;
+	if (!uring || (sock->poll != pollobj) || (sock->fd == NETWORK_SOCKET_INVALID))
+		return false;
+	index = network_poll_uring_op_allocate(uring, sock, type);
+	uring->ops[index - 1].buffer = buffer;
+	sqe = network_poll_uring_sqe(uring, index);
+	if (!sqe) {
+		network_poll_uring_op_deallocate(uring, index);
+		return false;
+	}
+	sqe->opcode = (type == NETWORK_POLL_URING_OP_READ) ? IORING_OP_RECV : IORING_OP_SEND;
+	sqe->fd = sock->fd;
+	sqe->addr = (uint64_t)(uintptr_t)buffer;
+	sqe->len = (uint32_t)size;
+	++pollobj->slots[sock->poll_slot].io;
+	return true;
+}
+
+static size_t
+network_poll_uring_reap(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity) {
+	network_poll_uring_t* uring = pollobj->uring;
+	size_t num_events = 0;
+	unsigned int head = *uring->cq_head;
+	unsigned int tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+	//Completions beyond capacity are left in the ring for the next call
+	while ((head != tail) && (num_events < capacity)) {
+		struct io_uring_cqe* cqe = uring->cqes + (head & *uring->cq_mask);
+		uint64_t user_data = cqe->user_data;
+		int res = cqe->res;
+		++head;
+		__atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+
+		if ((user_data == NETWORK_POLL_URING_IGNORE) || (user_data == NETWORK_POLL_URING_TIMEOUT))
+			continue;
+		if (user_data == NETWORK_POLL_URING_WAKEUP) {
+			network_poll_wakeup_drain(pollobj);
+			network_poll_uring_arm_wakeup(pollobj);
+			continue;
+		}
+
+		unsigned int index = (unsigned int)user_data;
+		network_poll_uring_op_t* op = uring->ops + (index - 1);
+		socket_t* sock = op->sock;
+		void* buffer = op->buffer;
+		unsigned int type = op->type;
+		network_poll_uring_op_deallocate(uring, index);
+
+		if (type == NETWORK_POLL_URING_OP_FD) {
+			network_poll_fd_t* entry = buffer;
+			unsigned int revents = (res > 0) ? (unsigned int)res : 0;
+			unsigned int ready;
+			if (!entry)
+				continue;
+			entry->op = NETWORK_POLL_URING_OP_NONE;
+			ready = network_poll_fd_ready(entry, revents & POLLIN, revents & POLLOUT,
+			                              revents & POLLERR, revents & POLLHUP);
+			if (ready)
+				network_poll_push_completion(pollobj, events, capacity, num_events, NETWORKEVENT_FD,
+				                             nullptr, entry->data, (int)ready);
+			network_poll_uring_update_fd(uring, entry);
+		}
+		else if (type == NETWORK_POLL_URING_OP_POLL) {
+			unsigned int revents = (res > 0) ? (unsigned int)res : 0;
+			if (!sock)
+				continue;
+			pollobj->slots[sock->poll_slot].op = NETWORK_POLL_URING_OP_NONE;
+			network_poll_process_socket(pollobj, sock, revents & POLLIN, revents & POLLOUT,
+			                            revents & POLLERR, revents & POLLHUP, revents & POLLRDHUP,
+			                            events, capacity, &num_events);
+			if (sock->poll == pollobj)
+				network_poll_update_slot(pollobj, sock->poll_slot, sock);
+		}
+		else {
+			if (sock)
+				--pollobj->slots[sock->poll_slot].io;
+			network_poll_push_completion(pollobj, events, capacity, num_events,
+			                             (type == NETWORK_POLL_URING_OP_READ) ?
+			                             NETWORKEVENT_READ_COMPLETE : NETWORKEVENT_WRITE_COMPLETE,
+			                             sock, buffer, res);
+		}
+	}
+	return num_events;
+}
+
+static size_t
+network_poll_uring_wait(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                        unsigned int timeoutms) {
+	network_poll_uring_t* uring = pollobj->uring;
+	size_t num_events;
+	if (uring->rearm || uring->rearm_wakeup)
+		network_poll_uring_rearm(pollobj);
+	num_events = network_poll_uring_reap(pollobj, events, capacity);
+	if (num_events || !timeoutms) {
+		//Flush queued submissions without waiting
+		if (uring->sq_queued)
+			network_poll_uring_enter(uring, 0);
+		return num_events;
+	}
+	if (timeoutms != NETWORK_TIMEOUT_INFINITE) {
+		//Timeout also completes on the first other completion, so never outlives the wait
+		struct io_uring_sqe* sqe = network_poll_uring_sqe(uring, NETWORK_POLL_URING_TIMEOUT);
+		if (!sqe)
+			return num_events;
+		uring->timeout.tv_sec = timeoutms / 1000;
+		uring->timeout.tv_nsec = (long long)(timeoutms % 1000) * 1000000LL;
+		sqe->opcode = IORING_OP_TIMEOUT;
+		sqe->fd = -1;
+		sqe->addr = (uint64_t)(uintptr_t)&uring->timeout;
+		sqe->len = 1;
+		sqe->off = 1;
+		network_poll_uring_enter(uring, 1);
+	}
+	else {
+		network_poll_uring_enter(uring, 1);
+	}
+	network_poll_mark_waited(pollobj);
+	return network_poll_uring_reap(pollobj, events, capacity);
+}
 
-#elif FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+#endif
+
+static void
+network_poll_wait_error(void) {
+	int err = NETWORK_SOCKET_ERROR;
+	string_const_t errmsg = system_error_message(err);
+	log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS, STRING_CONST("Error in socket poll: %.*s (%d)"),
+	          STRING_FORMAT(errmsg), err);
+}
+
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+
+static size_t
+network_poll_epoll_wait(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                        unsigned int timeoutms) {
+	size_t num_events = 0;
+	int ret = epoll_wait(pollobj->fd_poll, pollobj->events,
+	                     (int)pollobj->max_sockets + 1, (int)timeoutms);
+	network_poll_mark_waited(pollobj);
+	if (ret < 0) {
+		network_poll_wait_error();
+		return 0;
+	}
 
 	struct epoll_event* event = pollobj->events;
-	for (int i = 0; i < num_polled; ++i, ++event) {
-		socket_t* sock = pollobj->slots[ event->data.fd ].sock;
-		bool update_slot = false;
-		bool had_error = false;
-		if (event->events & EPOLLERR) {
-			update_slot = true;
-			had_error = true;
-			network_poll_push_event(events, capacity, num_events, NETWORKEVENT_ERROR, sock);
-			socket_close(sock);
+	for (int i = 0; i < ret; ++i, ++event) {
+		socket_t* sock = event->data.ptr;
+		if (event->data.ptr == pollobj) {
+			network_poll_wakeup_drain(pollobj);
+			continue;
 		}
-		if (event->events & EPOLLHUP) {
-			update_slot = true;
-			had_error = true;
-			network_poll_push_event(events, capacity, num_events, NETWORKEVENT_HANGUP, sock);
-			socket_close(sock);
+		if ((uintptr_t)event->data.ptr & NETWORK_POLL_FD_TAG) {
+			network_poll_fd_t* entry = pointer_offset(event->data.ptr, -NETWORK_POLL_FD_TAG);
+			unsigned int ready = network_poll_fd_ready(entry, event->events & EPOLLIN, event->events & EPOLLOUT,
+			                                           event->events & EPOLLERR, event->events & EPOLLHUP);
+			if (ready)
+				network_poll_push_completion(pollobj, events, capacity, num_events, NETWORKEVENT_FD,
+				                             nullptr, entry->data, (int)ready);
+			continue;
 		}
-		if (!had_error && (event->events & EPOLLIN)) {
-			if (sock->state == SOCKETSTATE_LISTENING) {
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_CONNECTION, sock);
-			}
-			else {
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_DATAIN, sock);
-			}
+		if (network_poll_process_socket(pollobj, sock, event->events & EPOLLIN, event->events & EPOLLOUT,
+		                                event->events & EPOLLERR, event->events & EPOLLHUP,
+		                                event->events & EPOLLRDHUP, events, capacity, &num_events))
+			network_poll_update_slot(pollobj, sock->poll_slot, sock);
+	}
+
+	return num_events;
+}
+
+#endif
+
+#if FOUNDATION_PLATFORM_POSIX
+
+static size_t
+network_poll_pollfd_wait(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                         unsigned int timeoutms) {
+	size_t num_events = 0;
+
+	//Wakeup descriptor is polled in the extra entry after the last slot
+	struct pollfd* pfdwakeup = pollobj->pollfds + pollobj->num_sockets;
+	pfdwakeup->fd = network_poll_wakeup_fd(pollobj);
+	pfdwakeup->events = POLLIN;
+	pfdwakeup->revents = 0;
+	size_t num_fds = array_size(pollobj->fds);
+	nfds_t num_pollfds = (nfds_t)pollobj->num_sockets + 1;
+	struct pollfd* pollfds = pollobj->pollfds;
+	if (num_fds) {
+		//Raw descriptors follow the wakeup descriptor in a scratch copy of the poll array
+		array_resize(pollobj->pollscratch, num_pollfds + num_fds);
+		pollfds = pollobj->pollscratch;
+		memcpy(pollfds, pollobj->pollfds, sizeof(struct pollfd) * num_pollfds);
+		for (size_t ifd = 0; ifd < num_fds; ++ifd) {
+			struct pollfd* pfdraw = pollfds + num_pollfds + ifd;
+			pfdraw->fd = pollobj->fds[ifd]->fd;
+			pfdraw->events = ((pollobj->fds[ifd]->mask & NETWORK_POLLFD_READ) ? POLLIN : 0) |
+			                 ((pollobj->fds[ifd]->mask & NETWORK_POLLFD_WRITE) ? POLLOUT : 0);
+			pfdraw->revents = 0;
 		}
-		if (!had_error && (sock->state == SOCKETSTATE_CONNECTING) && (event->events & EPOLLOUT)) {
-			int serr = 0;
-			socklen_t slen = sizeof(int);
-			getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
-			if (!serr) {
-				sock->state = SOCKETSTATE_CONNECTED;
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_CONNECTED, sock);
-			}
-			else {
-				had_error = true;
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_ERROR, sock);
-				socket_close(sock);
-			}
-			update_slot = true;
+	}
+	int ret = poll(pollfds, num_pollfds + (nfds_t)num_fds,
+	               (timeoutms != NETWORK_TIMEOUT_INFINITE) ? (int)timeoutms : -1);
+	network_poll_mark_waited(pollobj);
+	if (ret < 0) {
+		network_poll_wait_error();
+		return 0;
+	}
+	if (!ret)
+		return 0;
+	if (num_fds)
+		memcpy(pollobj->pollfds, pollfds, sizeof(struct pollfd) * num_pollfds);
+
+	if (pfdwakeup->revents & POLLIN)
+		network_poll_wakeup_drain(pollobj);
+
+	for (size_t ifd = 0; ifd < num_fds; ++ifd) {
+		const struct pollfd* pfdraw = pollfds + num_pollfds + ifd;
+		unsigned int ready = network_poll_fd_ready(pollobj->fds[ifd], pfdraw->revents & POLLIN,
+		                                           pfdraw->revents & POLLOUT, pfdraw->revents & POLLERR,
+		                                           pfdraw->revents & POLLHUP);
+		if (ready)
+			network_poll_push_completion(pollobj, events, capacity, num_events, NETWORKEVENT_FD,
+			                             nullptr, pollobj->fds[ifd]->data, (int)ready);
+	}
+
+	struct pollfd* pfd = pollobj->pollfds;
+	network_poll_slot_t* slot = pollobj->slots;
+	for (size_t islot = 0; islot < pollobj->num_sockets; ++islot, ++pfd, ++slot) {
+		if (!pfd->revents)
+			continue;
+		if (network_poll_process_socket(pollobj, slot->sock, pfd->revents & POLLIN, pfd->revents & POLLOUT,
+		                                pfd->revents & POLLERR, pfd->revents & POLLHUP,
+		                                pfd->revents & POLLRDHUP, events, capacity, &num_events))
+			network_poll_update_slot(pollobj, islot, slot->sock);
+	}
+
+	return num_events;
+}
+
+#endif
+
+#if FOUNDATION_PLATFORM_WINDOWS
+
+static size_t
+network_poll_select_wait(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                         unsigned int timeoutms) {
+	//TODO: Refactor to keep fd_set across loop and rebuild on change (add/remove)
+	size_t num_events = 0;
+	int num_fd = 0;
+	int ret = 0;
+	size_t islot;
+	fd_set fdread, fdwrite, fderr;
+	struct timeval tv;
+
+	FD_ZERO(&fdread);
+	FD_ZERO(&fdwrite);
+	FD_ZERO(&fderr);
+
+	if (pollobj->fd_wakeup != NETWORK_SOCKET_INVALID) {
+		FD_SET(pollobj->fd_wakeup, &fdread);
+		num_fd = pollobj->fd_wakeup + 1;
+	}
+
+	//Raw descriptors must be socket handles, select does not support other handle types
+	for (islot = 0; islot < array_size(pollobj->fds); ++islot) {
+		const network_poll_fd_t* entry = pollobj->fds[islot];
+		if (entry->mask & NETWORK_POLLFD_READ)
+			FD_SET(entry->fd, &fdread);
+		if (entry->mask & NETWORK_POLLFD_WRITE)
+			FD_SET(entry->fd, &fdwrite);
+		FD_SET(entry->fd, &fderr);
+		if (entry->fd >= num_fd)
+			num_fd = entry->fd + 1;
+	}
+
+	for (islot = 0; islot < pollobj->num_sockets; ++islot) {
+		int fd = pollobj->slots[islot].fd;
+		if (fd != NETWORK_SOCKET_INVALID) {
+			socket_t* sock = pollobj->slots[islot].sock;
+
+			FD_SET(fd, &fdread);
+			if ((sock->state == SOCKETSTATE_CONNECTING) ||
+			    ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & NETWORK_POLL_WRITE_MASK)))
+				FD_SET(fd, &fdwrite);
+			FD_SET(fd, &fderr);
+
+			if (fd >= num_fd)
+				num_fd = fd + 1;
 		}
-		if (update_slot)
-			network_poll_update_slot(pollobj, (size_t)event->data.fd, sock);
 	}
 
-#elif FOUNDATION_PLATFORM_WINDOWS
+	if (!num_fd)
+		return num_events;
+
+	tv.tv_sec  = timeoutms / 1000;
+	tv.tv_usec = (timeoutms % 1000) * 1000;
+
+	ret = select(num_fd, &fdread, &fdwrite, &fderr,
+	             (timeoutms != NETWORK_TIMEOUT_INFINITE) ? &tv : nullptr);
+	network_poll_mark_waited(pollobj);
+	if (ret < 0) {
+		network_poll_wait_error();
+		return num_events;
+	}
+	if (!ret)
+		return num_events;
+
+	if ((pollobj->fd_wakeup != NETWORK_SOCKET_INVALID) && FD_ISSET(pollobj->fd_wakeup, &fdread))
+		network_poll_wakeup_drain(pollobj);
+
+	for (islot = 0; islot < array_size(pollobj->fds); ++islot) {
+		network_poll_fd_t* entry = pollobj->fds[islot];
+		unsigned int ready = network_poll_fd_ready(entry, FD_ISSET(entry->fd, &fdread),
+		                                           FD_ISSET(entry->fd, &fdwrite),
+		                                           FD_ISSET(entry->fd, &fderr), false);
+		if (ready)
+			network_poll_push_completion(pollobj, events, capacity, num_events, NETWORKEVENT_FD,
+			                             nullptr, entry->data, (int)ready);
+	}
 
 	for (islot = 0; islot < pollobj->num_sockets; ++islot) {
 		int fd = pollobj->slots[islot].fd;
@@ -376,29 +2034,356 @@ network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capac
 		bool update_slot = false;
 
 		if (FD_ISSET(fd, &fdread)) {
+			sock->flags &= ~SOCKETFLAG_DRAINED;
 			if (sock->state == SOCKETSTATE_LISTENING) {
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_CONNECTION, sock);
+				network_poll_push_event(pollobj, events, capacity, num_events, NETWORKEVENT_CONNECTION, sock);
 			}
 			else { //SOCKETSTATE_CONNECTED
-				network_poll_push_event(events, capacity, num_events, NETWORKEVENT_DATAIN, sock);
+				network_poll_push_event(pollobj, events, capacity, num_events, NETWORKEVENT_DATAIN, sock);
 			}
 		}
-		if ((sock->state == SOCKETSTATE_CONNECTING) && FD_ISSET(fd, &fdwrite)) {
+		if ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & NETWORK_POLL_WRITE_MASK) &&
+		    FD_ISSET(fd, &fdwrite)) {
+			if (sock->flags & SOCKETFLAG_OUTPUT_QUEUED)
+				update_slot = network_poll_flush_output(pollobj, sock, events, capacity, &num_events);
+			if ((sock->state == SOCKETSTATE_CONNECTED) && (sock->flags & SOCKETFLAG_POLL_WRITE))
+				network_poll_push_event(pollobj, events, capacity, num_events, NETWORKEVENT_DATAOUT, sock);
+		}
+		else if ((sock->state == SOCKETSTATE_CONNECTING) && FD_ISSET(fd, &fdwrite)) {
 			update_slot = true;
 			sock->state = SOCKETSTATE_CONNECTED;
-			network_poll_push_event(events, capacity, num_events, NETWORKEVENT_CONNECTED, sock);
+			network_poll_push_event(pollobj, events, capacity, num_events, NETWORKEVENT_CONNECTED, sock);
 		}
 		if (FD_ISSET(fd, &fderr)) {
 			update_slot = true;
-			network_poll_push_event(events, capacity, num_events, NETWORKEVENT_HANGUP, sock);
+			network_poll_push_event(pollobj, events, capacity, num_events, NETWORKEVENT_HANGUP, sock);
 			socket_close(sock);
 		}
 		if (update_slot)
 			network_poll_update_slot(pollobj, islot, sock);
 	}
-#else
-#  error Not implemented
+
+	return num_events;
+}
+
+#endif
+
+static size_t
+network_poll_wait(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                  unsigned int timeoutms) {
+	size_t num_events = 0;
+	tick_t start = 0;
+
+	network_poll_apply_changes(pollobj);
+
+	if (pollobj->flags & NETWORK_POLLFLAG_INSTRUMENTED)
+		pollobj->waited = start = time_current();
+
+	switch (pollobj->backend) {
+#if BUILD_ENABLE_NETWORK_IO_URING
+	case NETWORK_POLL_BACKEND_IO_URING:
+		num_events = network_poll_uring_wait(pollobj, events, capacity, timeoutms);
+		break;
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	case NETWORK_POLL_BACKEND_EPOLL:
+		num_events = network_poll_epoll_wait(pollobj, events, capacity, timeoutms);
+		break;
+#endif
+#if FOUNDATION_PLATFORM_POSIX
+	case NETWORK_POLL_BACKEND_POLL:
+		num_events = network_poll_pollfd_wait(pollobj, events, capacity, timeoutms);
+		break;
+#endif
+#if FOUNDATION_PLATFORM_WINDOWS
+	case NETWORK_POLL_BACKEND_SELECT:
+		num_events = network_poll_select_wait(pollobj, events, capacity, timeoutms);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	//Skip empty zero-timeout spins, which would drown the distributions
+	if ((pollobj->flags & NETWORK_POLLFLAG_INSTRUMENTED) && (num_events || timeoutms)) {
+		network_poll_statistics_t* stats = &pollobj->statistics;
+		_network_poll_histogram_record(&stats->wait, _network_poll_ticks_to_us(pollobj->waited - start));
+		_network_poll_histogram_record(&stats->process,
+		                               _network_poll_ticks_to_us(time_elapsed_ticks(pollobj->waited)));
+		_network_poll_histogram_record(&stats->events, num_events);
+	}
+
+	return num_events;
+}
+
+//Spin with zero-timeout waits for the busy poll budget before falling back to a blocking wait
+static size_t
+network_poll_wait_busy(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                       unsigned int timeoutms) {
+	size_t num_polled;
+	if (pollobj->busy_poll && timeoutms) {
+		tick_t start = time_current();
+		tick_t budget = (time_ticks_per_second() * (tick_t)pollobj->busy_poll) / 1000000LL;
+		tick_t elapsed;
+		pollobj->flags &= ~(unsigned int)NETWORK_POLLFLAG_WOKEN;
+		do {
+			num_polled = network_poll_wait(pollobj, events, capacity, 0);
+			if (num_polled) {
+				++pollobj->statistics.spin_hits;
+				return num_polled;
+			}
+			//Wakeup without events is neither a hit nor a spin
+			if (pollobj->flags & NETWORK_POLLFLAG_WOKEN)
+				return 0;
+			++pollobj->statistics.spins;
+			elapsed = time_elapsed_ticks(start);
+		} while (elapsed < budget);
+		if (timeoutms != NETWORK_TIMEOUT_INFINITE) {
+			unsigned int elapsedms = (unsigned int)((elapsed * 1000LL) / time_ticks_per_second());
+			if (elapsedms >= timeoutms)
+				return 0;
+			timeoutms -= elapsedms;
+		}
+	}
+	if (timeoutms)
+		++pollobj->statistics.sleeps;
+	return network_poll_wait(pollobj, events, capacity, timeoutms);
+}
+
+//Descriptor signalling readiness of any registration, usable from another poll or beacon
+static int
+network_poll_aggregate_fd(network_poll_t* pollobj) {
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring)
+		return pollobj->uring->fd;
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	if (pollobj->backend == NETWORK_POLL_BACKEND_EPOLL)
+		return pollobj->fd_poll;
 #endif
+	FOUNDATION_UNUSED(pollobj);
+	return NETWORK_SOCKET_INVALID;
+}
+
+int
+network_poll_set_beacon(network_poll_t* pollobj, beacon_t* beacon) {
+	int fd = network_poll_aggregate_fd(pollobj);
+	int index = -1;
+	if (pollobj->beacon && (fd != NETWORK_SOCKET_INVALID))
+		beacon_remove_fd(pollobj->beacon, fd);
+	pollobj->beacon = nullptr;
+	if (!beacon)
+		return -1;
+	if (fd == NETWORK_SOCKET_INVALID) {
+		log_warn(HASH_NETWORK, WARNING_UNSUPPORTED,
+		         STRING_CONST("Network poll: Attaching to beacon not supported by backend"));
+		return -1;
+	}
+	index = beacon_add_fd(beacon, fd);
+	if (index >= 0)
+		pollobj->beacon = beacon;
+	return index;
+}
+
+unsigned int
+network_poll_prepare(network_poll_t* pollobj, unsigned int timeoutms) {
+	if (atomic_load32(&pollobj->queued, memory_order_acquire))
+		_network_poll_apply_queue(pollobj);
+	network_poll_apply_changes(pollobj);
+#if BUILD_ENABLE_NETWORK_IO_URING
+	if (pollobj->uring && pollobj->uring->sq_queued)
+		network_poll_uring_enter(pollobj->uring, 0);
+#endif
+	if (pollobj->pending_next < array_size(pollobj->pending))
+		return 0;
+	return _network_poll_timers_update(pollobj, timeoutms);
+}
+
+static size_t
+network_poll_pop_pending(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity) {
+	size_t num_events = array_size(pollobj->pending) - pollobj->pending_next;
+	if (num_events > capacity)
+		num_events = capacity;
+	memcpy(events, pollobj->pending + pollobj->pending_next, sizeof(network_poll_event_t) * num_events);
+	pollobj->pending_next += num_events;
+	if (pollobj->pending_next >= array_size(pollobj->pending)) {
+		array_clear(pollobj->pending);
+		pollobj->pending_next = 0;
+	}
+	return num_events;
+}
+
+//Order the returned and pending events of a wait by priority class of the socket, keeping
+//arrival order within a class. Pending events are then never of higher priority than returned
+//events, so the order is kept as they are returned by later calls
+static void
+network_poll_prioritize(network_poll_t* pollobj, network_poll_event_t* events, size_t num_events) {
+	size_t ievt, esize, iclass;
+	size_t num_pending = array_size(pollobj->pending) - pollobj->pending_next;
+	if (!pollobj->num_prioritized || (num_events + num_pending < 2))
+		return;
+	array_clear(pollobj->sorted);
+	for (iclass = 0; iclass < NETWORK_POLL_PRIORITY_COUNT; ++iclass) {
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			if (_network_poll_event_priority(pollobj, events + ievt) == iclass)
+				array_push(pollobj->sorted, events[ievt]);
+		}
+		for (ievt = pollobj->pending_next, esize = array_size(pollobj->pending); ievt < esize; ++ievt) {
+			if (_network_poll_event_priority(pollobj, pollobj->pending + ievt) == iclass)
+				array_push(pollobj->sorted, pollobj->pending[ievt]);
+		}
+	}
+	memcpy(events, pollobj->sorted, sizeof(network_poll_event_t) * num_events);
+	memcpy(pollobj->pending + pollobj->pending_next, pollobj->sorted + num_events,
+	       sizeof(network_poll_event_t) * num_pending);
+}
+
+void
+_network_poll_requeue(network_poll_t* pollobj, const network_poll_event_t* events, size_t num_events) {
+	size_t num_pending = array_size(pollobj->pending) - pollobj->pending_next;
+	if (pollobj->pending_next < num_events) {
+		memmove(pollobj->pending, pollobj->pending + pollobj->pending_next,
+		        sizeof(network_poll_event_t) * num_pending);
+		array_resize(pollobj->pending, num_pending + num_events);
+		memmove(pollobj->pending + num_events, pollobj->pending, sizeof(network_poll_event_t) * num_pending);
+		pollobj->pending_next = num_events;
+	}
+	pollobj->pending_next -= num_events;
+	memcpy(pollobj->pending + pollobj->pending_next, events, sizeof(network_poll_event_t) * num_events);
+}
 
+void
+_network_poll_push(network_poll_t* pollobj, network_event_id event, socket_t* sock, int result) {
+	network_poll_event_t* evt;
+	array_resize(pollobj->pending, array_size(pollobj->pending) + 1);
+	evt = pollobj->pending + array_size(pollobj->pending) - 1;
+	evt->event = event;
+	evt->socket = sock;
+	evt->buffer = nullptr;
+	evt->result = result;
+}
+
+//Return buffers of zero-copy sends whose completion is no longer observed, with a failed
+//result. Completions for a socket leaving the poll carry no socket
+void
+_network_poll_zerocopy_cancel(network_poll_t* pollobj, socket_t* sock, bool removed) {
+	size_t irec, rsize;
+	for (irec = 0, rsize = array_size(sock->zerocopy); irec < rsize; ++irec) {
+		_network_poll_push(pollobj, NETWORKEVENT_SEND_COMPLETE, removed ? nullptr : sock, -1);
+		pollobj->pending[array_size(pollobj->pending) - 1].buffer = (void*)(uintptr_t)sock->zerocopy[irec].buffer;
+	}
+	array_clear(sock->zerocopy);
+}
+
+size_t
+network_poll_num_pending(network_poll_t* pollobj) {
+	return array_size(pollobj->pending) - pollobj->pending_next;
+}
+
+//Readiness reported again by a level triggered wait for a socket or descriptor with the
+//same event still in the backlog carries no new information
+static bool
+network_poll_pending_repeated(const network_poll_t* pollobj, const network_poll_event_t* event,
+                              size_t backlog) {
+	size_t ievt;
+	switch (event->event) {
+	case NETWORKEVENT_CONNECTION:
+	case NETWORKEVENT_DATAIN:
+	case NETWORKEVENT_DATAOUT:
+	case NETWORKEVENT_HANGUP:
+	case NETWORKEVENT_ERROR:
+	case NETWORKEVENT_FD:
+		break;
+	default:
+		return false;
+	}
+	for (ievt = pollobj->pending_next; ievt < backlog; ++ievt) {
+		const network_poll_event_t* pending = pollobj->pending + ievt;
+		if ((pending->event == event->event) && (pending->socket == event->socket) &&
+		    (pending->buffer == event->buffer) && (pending->result == event->result))
+			return true;
+	}
+	return false;
+}
+
+//Merge events collected while a backlog was pending in behind it, ordered by priority class,
+//and return the first events. The backlog ends at the given index, events kept beyond the
+//capacity during the wait follow it and arrived after the events in the array
+static size_t
+network_poll_merge_pending(network_poll_t* pollobj, network_poll_event_t* events, size_t num_events,
+                           size_t capacity, size_t backlog) {
+	size_t ievt, ikeep, esize;
+	size_t num_overflow = array_size(pollobj->pending) - backlog;
+	if (num_events) {
+		array_resize(pollobj->pending, backlog + num_overflow + num_events);
+		memmove(pollobj->pending + backlog + num_events, pollobj->pending + backlog,
+		        sizeof(network_poll_event_t) * num_overflow);
+		memcpy(pollobj->pending + backlog, events, sizeof(network_poll_event_t) * num_events);
+	}
+	for (ievt = ikeep = backlog, esize = array_size(pollobj->pending); ievt < esize; ++ievt) {
+		if (!network_poll_pending_repeated(pollobj, pollobj->pending + ievt, backlog))
+			pollobj->pending[ikeep++] = pollobj->pending[ievt];
+	}
+	array_resize(pollobj->pending, ikeep);
+	network_poll_prioritize(pollobj, events, 0);
+	num_events = network_poll_pop_pending(pollobj, events, capacity);
+	if (pollobj->timers)
+		_network_poll_timers_socket_events(pollobj, events, num_events);
+	return num_events;
+}
+
+static size_t
+network_poll_collect(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+                     unsigned int timeoutms) {
+	size_t num_events = 0;
+	size_t num_polled;
+	size_t backlog;
+
+	if (atomic_load32(&pollobj->queued, memory_order_acquire))
+		_network_poll_apply_queue(pollobj);
+
+	//Events left over from previous calls are returned without blocking, but merged with the
+	//events ready now so a backlog of low priority events cannot hold back higher priorities
+	backlog = (pollobj->pending_next < array_size(pollobj->pending)) ? array_size(pollobj->pending) : 0;
+	if (backlog)
+		timeoutms = 0;
+
+	if (pollobj->timers) {
+		//Deliver expired timers first, and wait no longer than the nearest deadline
+		timeoutms = _network_poll_timers_update(pollobj, timeoutms);
+		num_events = _network_poll_timers_expired(pollobj, events, capacity);
+		if (num_events)
+			timeoutms = 0;
+	}
+
+	if (num_events < capacity) {
+		num_polled = network_poll_wait_busy(pollobj, events + num_events, capacity - num_events, timeoutms);
+		if (pollobj->timers) {
+			_network_poll_timers_socket_events(pollobj, events + num_events, num_polled);
+			num_events += num_polled;
+			//Deliver timers expiring during the wait
+			_network_poll_timers_update(pollobj, 0);
+			num_events += _network_poll_timers_expired(pollobj, events + num_events, capacity - num_events);
+		}
+		else {
+			num_events += num_polled;
+		}
+	}
+
+	if (backlog)
+		return network_poll_merge_pending(pollobj, events, num_events, capacity, backlog);
+	network_poll_prioritize(pollobj, events, num_events);
+	return num_events;
+}
+
+size_t
+network_poll(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity,
+             unsigned int timeoutms) {
+	size_t num_events;
+	if (pollobj->returned)
+		network_poll_check_gap(pollobj);
+	num_events = network_poll_collect(pollobj, events, capacity, timeoutms);
+	if ((pollobj->flags & NETWORK_POLLFLAG_INSTRUMENTED) || pollobj->watchdog)
+		pollobj->returned = time_current();
 	return num_events;
 }
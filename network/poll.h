@@ -18,9 +18,28 @@
 
 #include <network/types.h>
 
+/*! Allocate a poll. The poll grows its storage on demand when adding sockets
+beyond the initial capacity.
+\param num_sockets Initial socket capacity, can be 0
+\return New poll */
 NETWORK_API network_poll_t*
 network_poll_allocate(unsigned int num_sockets);
 
+/*! Allocate a poll using the given backend, allowing the backends available on a
+platform to be compared on the same workload. Linux supports epoll (default), poll and
+io_uring (if enabled in build), macOS and iOS support poll and Windows supports select.
+If the backend is not available in the build or on the running system the poll falls
+back to the default backend, use #network_poll_backend to query the backend in use.
+\param num_sockets Initial socket capacity, can be 0
+\param backend Backend
+\return New poll */
+NETWORK_API network_poll_t*
+network_poll_allocate_backend(unsigned int num_sockets, network_poll_backend_t backend);
+
+/*! Initialize a poll declared with NETWORK_DECLARE_FIXEDSIZE_POLL. The capacity
+is fixed and adding sockets fails once the poll is full.
+\param poll Poll
+\param num_sockets Socket capacity, must match the declared size */
 NETWORK_API void
 network_poll_initialize(network_poll_t* poll, unsigned int num_sockets);
 
@@ -30,6 +49,12 @@ network_poll_finalize(network_poll_t* poll);
 NETWORK_API void
 network_poll_deallocate(network_poll_t* poll);
 
+/*! Add socket to poll. A socket can only be part of one poll at a time, and
+is automatically removed from the poll when finalized.
+\param poll Poll
+\param sock Socket
+\return true if socket was added (or already in the poll), false if a fixed size poll
+        is full or socket is already part of another poll */
 NETWORK_API bool
 network_poll_add_socket(network_poll_t* poll, socket_t* sock);
 
@@ -39,15 +64,284 @@ network_poll_update_socket(network_poll_t* poll, socket_t* sock);
 NETWORK_API void
 network_poll_remove_socket(network_poll_t* poll, socket_t* sock);
 
+/*! Arm or disarm write interest for a connected socket. While armed the poll delivers
+NETWORKEVENT_DATAOUT when the socket can accept more data, allowing non-blocking writers
+to park output on a partial #socket_write and resume once the send buffer drains.
+Level-triggered polls keep reporting the event until interest is disarmed.
+\param poll Poll
+\param sock Socket
+\param interest true to arm write interest, false to disarm */
+NETWORK_API void
+network_poll_set_write_interest(network_poll_t* poll, socket_t* sock, bool interest);
+
+/*! Query if write interest is armed for the socket in the given poll
+\param poll Poll
+\param sock Socket
+\return true if armed, false if not */
+NETWORK_API bool
+network_poll_write_interest(const network_poll_t* poll, const socket_t* sock);
+
+/*! Set the priority class of a socket in the poll. Events of each wait are returned
+ordered by priority class, keeping arrival order within a class, so events of higher
+priority sockets (like listening or control sockets) are returned first and never left
+pending by the capacity of a #network_poll call while lower priority events are returned.
+Events without a socket have normal priority. The priority is reset to
+NETWORK_POLL_PRIORITY_NORMAL when the socket is removed from the poll.
+\param poll Poll
+\param sock Socket
+\param priority Priority class */
+NETWORK_API void
+network_poll_set_priority(network_poll_t* poll, socket_t* sock, network_poll_priority_t priority);
+
+/*! Query the priority class of a socket in the poll
+\param poll Poll
+\param sock Socket
+\return Priority class, NETWORK_POLL_PRIORITY_NORMAL if socket not in poll */
+NETWORK_API network_poll_priority_t
+network_poll_priority(const network_poll_t* poll, const socket_t* sock);
+
 NETWORK_API bool
 network_poll_has_socket(network_poll_t* poll, socket_t* sock);
 
+/*! Add a raw descriptor (for example a timerfd, pipe or eventfd) to the poll. Readiness
+is returned as NETWORKEVENT_FD events without socket, with the user data as buffer and
+the ready flags (network_poll_fd_flag_t) as result. Errors and hangups are always
+reported. The descriptor is not owned by the poll and must be removed before closed.
+On Windows the descriptor must be a socket handle.
+\param poll Poll
+\param fd Descriptor
+\param mask Flags to wait for, combination of NETWORK_POLLFD_READ and NETWORK_POLLFD_WRITE
+\param data User data
+\return true if added, false if descriptor invalid or already in poll */
+NETWORK_API bool
+network_poll_add_fd(network_poll_t* poll, int fd, unsigned int mask, void* data);
+
+/*! Change the flags waited for on a raw descriptor in the poll
+\param poll Poll
+\param fd Descriptor
+\param mask Flags to wait for
+\return true if updated, false if descriptor not in poll or error */
+NETWORK_API bool
+network_poll_update_fd(network_poll_t* poll, int fd, unsigned int mask);
+
+/*! Remove a raw descriptor from the poll, discarding pending events for it
+\param poll Poll
+\param fd Descriptor */
+NETWORK_API void
+network_poll_remove_fd(network_poll_t* poll, int fd);
+
+/*! Query number of raw descriptors in the poll
+\param poll Poll
+\return Number of raw descriptors */
+NETWORK_API size_t
+network_poll_num_fds(network_poll_t* poll);
+
+/*! Query busy poll budget
+\param poll Poll
+\return Busy poll budget in microseconds, 0 if busy polling is disabled */
+NETWORK_API unsigned int
+network_poll_busy_poll(const network_poll_t* poll);
+
+/*! Set busy poll mode. With a non-zero budget #network_poll spins with zero-timeout
+waits for up to the budget before falling back to a blocking wait for the remaining
+timeout, trading CPU time for wakeup latency. On Linux SO_BUSY_POLL and
+SO_PREFER_BUSY_POLL are also set on sockets in the poll, where permitted, and cleared
+when busy polling is disabled or the socket is removed from the poll.
+\param poll Poll
+\param budgetus Busy poll budget in microseconds, 0 to disable busy polling */
+NETWORK_API void
+network_poll_set_busy_poll(network_poll_t* poll, unsigned int budgetus);
+
+/*! Query wait statistics, used to tune the busy poll budget and diagnose event loop
+latency. Histograms are only collected with instrumentation enabled, see
+#network_poll_set_instrumented
+\param poll Poll
+\return Statistics accumulated since the poll was initialized or statistics reset */
+NETWORK_API network_poll_statistics_t
+network_poll_statistics(const network_poll_t* poll);
+
+/*! Reset wait statistics
+\param poll Poll */
+NETWORK_API void
+network_poll_reset_statistics(network_poll_t* poll);
+
+/*! Query if poll collects latency histograms
+\param poll Poll
+\return true if instrumented, false if not */
+NETWORK_API bool
+network_poll_instrumented(const network_poll_t* poll);
+
+/*! Enable collection of latency histograms in the poll statistics: time in the backend
+wait system call, time translating the backend results to events, events per wait, time
+between polls spent by the application, and time in dispatcher handlers. Costs a few
+clock reads per wait. Zero-timeout waits returning no events, like busy poll spins, are
+not recorded.
+\param poll Poll
+\param instrumented true to collect histograms, false to stop */
+NETWORK_API void
+network_poll_set_instrumented(network_poll_t* poll, bool instrumented);
+
+/*! Set the event loop watchdog. A call to #network_poll made longer than the threshold
+after the previous call returned is counted as a stall in the statistics and reported
+to the stall function, or logged as a warning if no function is set. Stalls are reported
+on the polling thread when the loop gets back to the poll.
+\param poll Poll
+\param thresholdus Threshold in microseconds, 0 to disable the watchdog
+\param fn Stall function called with the poll, stall time in microseconds and context, can be null
+\param context Context passed to the stall function */
+NETWORK_API void
+network_poll_set_watchdog(network_poll_t* poll, unsigned int thresholdus, network_poll_stall_fn fn,
+                          void* context);
+
+/*! Query a percentile of a histogram in the poll statistics. The result is the upper
+bound of the power of two bucket containing the percentile, capped by the largest value
+recorded.
+\param histogram Histogram
+\param percentile Percentile in range [0,1]
+\return Upper bound of the percentile value, 0 if the histogram is empty */
+NETWORK_API uint64_t
+network_poll_histogram_percentile(const network_poll_histogram_t* histogram, real percentile);
+
+/*! Wake up a thread waiting in #network_poll on the poll, which returns without
+waiting for the timeout. Thread safe, and wakeups issued before the poll thread
+observes the first one are coalesced.
+\param poll Poll */
+NETWORK_API void
+network_poll_wakeup(network_poll_t* poll);
+
+/*! Queue a socket to be added to the poll by the thread calling #network_poll, and wake
+up that thread. Thread safe. The socket is added at the start of the next #network_poll
+call, and is owned by the poll thread from the time of the call. Deallocating the socket
+before the add is applied discards the request.
+\param poll Poll
+\param sock Socket */
+NETWORK_API void
+network_poll_queue_add_socket(network_poll_t* poll, socket_t* sock);
+
+/*! Queue a socket to be removed from the poll by the thread calling #network_poll, and
+wake up that thread. Thread safe. Requests are applied in the order queued. The socket
+may only be deallocated after the removal has been applied (#network_poll_num_queued
+returns zero or the socket is no longer in the poll), as finalizing a socket still in
+the poll removes it on the calling thread.
+\param poll Poll
+\param sock Socket */
+NETWORK_API void
+network_poll_queue_remove_socket(network_poll_t* poll, socket_t* sock);
+
+/*! Query number of queued add and remove requests not yet applied
+\param poll Poll
+\return Number of queued requests */
+NETWORK_API size_t
+network_poll_num_queued(network_poll_t* poll);
+
+/*! Query backend used by the poll
+\param poll Poll
+\return Backend in use, never NETWORK_POLL_BACKEND_DEFAULT */
+NETWORK_API network_poll_backend_t
+network_poll_backend(const network_poll_t* poll);
+
+/*! Submit a completion-style read of up to the given number of bytes from a socket
+in the poll. Submissions are batched and passed to the kernel in the next call to
+#network_poll, which reports the result as a NETWORKEVENT_READ_COMPLETE event. The
+buffer must remain valid until the completion is reported. If the socket is removed
+from the poll the read is cancelled and its completion is reported with a null socket.
+Only supported by the io_uring backend.
+\param poll Poll
+\param sock Socket
+\param buffer Destination buffer
+\param size Buffer size
+\return true if submitted, false if not supported by the backend or socket not in poll */
+NETWORK_API bool
+network_poll_submit_read(network_poll_t* poll, socket_t* sock, void* buffer, size_t size);
+
+/*! Submit a completion-style write to a socket in the poll, reported as a
+NETWORKEVENT_WRITE_COMPLETE event. See #network_poll_submit_read for buffer lifetime
+and cancellation. Only supported by the io_uring backend.
+\param poll Poll
+\param sock Socket
+\param buffer Source buffer
+\param size Number of bytes to write
+\return true if submitted, false if not supported by the backend or socket not in poll */
+NETWORK_API bool
+network_poll_submit_write(network_poll_t* poll, socket_t* sock, const void* buffer, size_t size);
+
+/*! Query if poll defers registration changes
+\param poll Poll
+\return true if changes are deferred, false if applied immediately */
+NETWORK_API bool
+network_poll_deferred(const network_poll_t* poll);
+
+/*! Set deferred change mode. In deferred mode socket registrations and interest changes
+are queued and applied in a single pass before the next wait in #network_poll, and
+changes cancelling out (like adding and removing a socket, or arming and disarming
+write interest) result in no system calls. Disabling deferred mode applies queued
+changes immediately. Only affects polls on Linux.
+\param poll Poll
+\param deferred true to defer changes, false to apply them immediately */
+NETWORK_API void
+network_poll_set_deferred(network_poll_t* poll, bool deferred);
+
+/*! Query if poll is in edge-triggered mode
+\param poll Poll
+\return true if edge-triggered, false if level-triggered */
+NETWORK_API bool
+network_poll_edge_triggered(const network_poll_t* poll);
+
+/*! Set edge-triggered mode. In edge-triggered mode NETWORKEVENT_DATAIN and
+NETWORKEVENT_CONNECTION are only delivered when new data or connections arrive,
+and the socket must be drained (read or accepted until #socket_drained returns true)
+before waiting again. Only supported with epoll, other backends remain level-triggered.
+\param poll Poll
+\param edge_triggered true to enable edge-triggered mode, false for level-triggered */
+NETWORK_API void
+network_poll_set_edge_triggered(network_poll_t* poll, bool edge_triggered);
+
 NETWORK_API size_t
 network_poll_num_sockets(network_poll_t* poll);
 
 NETWORK_API void
 network_poll_sockets(network_poll_t* poll, socket_t** sockets, size_t max_sockets);
 
+/*! Attach the poll to a beacon, so that a single #beacon_wait covers sockets and raw
+descriptors in the poll as well as foundation events and thread signals. The beacon is
+fired with the returned index when the poll has events, which are then collected with
+#network_poll using a zero timeout. Call #network_poll_prepare before each beacon wait.
+Only supported by the epoll and io_uring backends, where the poll has a single descriptor
+to wait on.
+\param poll Poll
+\param beacon Beacon, null to detach the poll from its current beacon
+\return Beacon slot index signalled for poll events, -1 if detached or not supported */
+NETWORK_API int
+network_poll_set_beacon(network_poll_t* poll, beacon_t* beacon);
+
+/*! Prepare to wait for the poll through an attached beacon. Applies queued and
+deferred registration changes, submits pending io_uring operations and bounds the
+timeout by the nearest timer deadline.
+\param poll Poll
+\param timeoutms Timeout in milliseconds the caller intends to wait
+\return Timeout in milliseconds to wait, 0 if the poll already has pending events
+        or expired timers */
+NETWORK_API unsigned int
+network_poll_prepare(network_poll_t* poll, unsigned int timeoutms);
+
+/*! Query number of events kept in the poll after exceeding the capacity of a
+#network_poll call, returned by the next call
+\param poll Poll
+\return Number of pending events */
+NETWORK_API size_t
+network_poll_num_pending(network_poll_t* poll);
+
+/*! Poll sockets and timers for events. Events exceeding the capacity of the event
+array are kept in the poll and returned by the next call without blocking, so no
+events are lost with small event arrays. That call still checks for ready events
+and merges them with the pending ones by priority class. Pending events for sockets
+removed from the poll are discarded, except send completions which are kept without
+the socket so the buffer is still returned.
+\param poll Poll
+\param event Event array
+\param capacity Capacity of event array
+\param timeoutms Timeout in milliseconds to wait for events
+\return Number of events stored in event array */
 NETWORK_API size_t
 network_poll(network_poll_t* poll, network_poll_event_t* event, size_t capacity,
              unsigned int timeoutms);
@@ -0,0 +1,239 @@
+/* pollgroup.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/network.h>
+#include <network/pollgroup.h>
+#include <network/poll.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_PLATFORM_LINUX
+#  include <sched.h>
+#endif
+
+#define NETWORK_POLL_GROUP_EVENTS 64
+
+//Lock orders the published load with enqueued sockets not yet seen by the worker
+static void
+network_poll_shard_publish_load(network_poll_shard_t* shard) {
+	mutex_lock(shard->lock);
+	atomic_store32(&shard->load, (int32_t)(network_poll_num_sockets(shard->poll) +
+	                                       network_poll_num_queued(shard->poll)), memory_order_release);
+	mutex_unlock(shard->lock);
+}
+
+static void
+network_poll_shard_pin(network_poll_shard_t* shard) {
+#if FOUNDATION_PLATFORM_LINUX
+	size_t index = (size_t)(shard - shard->group->shards);
+	size_t num_cores = system_hardware_threads();
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET((int)(index % (num_cores ? num_cores : 1)), &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		int err = NETWORK_SOCKET_ERROR;
+		string_const_t errmsg = system_error_message(err);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Network poll group: Unable to pin shard %" PRIsize " worker: %.*s (%d)"),
+		          index, STRING_FORMAT(errmsg), err);
+	}
+#else
+	FOUNDATION_UNUSED(shard);
+#endif
+}
+
+static void*
+network_poll_shard_thread(void* arg) {
+	network_poll_shard_t* shard = arg;
+	network_poll_group_t* group = shard->group;
+	network_poll_event_t events[NETWORK_POLL_GROUP_EVENTS];
+
+	network_poll_shard_pin(shard);
+
+	while (atomic_load32(&group->running, memory_order_acquire)) {
+		//Queued sockets are added and stop requests wake up the wait
+		size_t num_events = network_poll(shard->poll, events, NETWORK_POLL_GROUP_EVENTS, group->timeout);
+		if (num_events)
+			group->handler(group, shard->poll, events, num_events);
+		network_poll_shard_publish_load(shard);
+	}
+
+	network_thread_finalize();
+	return 0;
+}
+
+static size_t
+network_poll_group_shard_index(network_poll_group_t* group, network_poll_t* poll) {
+	size_t ishard;
+	for (ishard = 0; ishard < group->num_shards; ++ishard) {
+		if (group->shards[ishard].poll == poll)
+			return ishard;
+	}
+	return group->num_shards;
+}
+
+static void
+network_poll_group_enqueue(network_poll_group_t* group, size_t index, socket_t* sock) {
+	network_poll_shard_t* shard = group->shards + index;
+	mutex_lock(shard->lock);
+	network_poll_queue_add_socket(shard->poll, sock);
+	atomic_incr32(&shard->load, memory_order_release);
+	//No worker to pick up the socket, register it immediately. Start flips the running
+	//state under the shard lock, so no worker can touch the poll until this is done
+	if (!atomic_load32(&group->running, memory_order_acquire))
+		_network_poll_apply_queue(shard->poll);
+	mutex_unlock(shard->lock);
+}
+
+network_poll_group_t*
+network_poll_group_allocate(size_t num_polls, unsigned int num_sockets,
+                            network_poll_group_fn handler, void* context) {
+	network_poll_group_t* group;
+	size_t ishard;
+
+	if (!num_polls)
+		num_polls = system_hardware_threads();
+	if (!num_polls)
+		num_polls = 1;
+
+	group = memory_allocate(HASH_NETWORK, sizeof(network_poll_group_t) +
+	                        sizeof(network_poll_shard_t) * num_polls, 0,
+	                        MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	group->handler = handler;
+	group->context = context;
+	group->num_shards = num_polls;
+
+	for (ishard = 0; ishard < num_polls; ++ishard) {
+		network_poll_shard_t* shard = group->shards + ishard;
+		shard->group = group;
+		shard->poll = network_poll_allocate(num_sockets);
+		shard->lock = mutex_allocate(STRING_CONST("network_poll_shard"));
+		thread_initialize(&shard->thread, network_poll_shard_thread, shard,
+		                  STRING_CONST("network_poll_shard"), THREAD_PRIORITY_NORMAL, 0);
+	}
+
+	return group;
+}
+
+void
+network_poll_group_deallocate(network_poll_group_t* group) {
+	size_t ishard;
+	if (!group)
+		return;
+	network_poll_group_stop(group);
+	for (ishard = 0; ishard < group->num_shards; ++ishard) {
+		network_poll_shard_t* shard = group->shards + ishard;
+		thread_finalize(&shard->thread);
+		network_poll_deallocate(shard->poll);
+		mutex_deallocate(shard->lock);
+	}
+	memory_deallocate(group);
+}
+
+bool
+network_poll_group_start(network_poll_group_t* group, unsigned int timeoutms) {
+	size_t ishard;
+	if (atomic_load32(&group->running, memory_order_acquire))
+		return true;
+	group->timeout = timeoutms;
+	//Wait out callers registering queued sockets on their own thread
+	for (ishard = 0; ishard < group->num_shards; ++ishard)
+		mutex_lock(group->shards[ishard].lock);
+	atomic_store32(&group->running, 1, memory_order_release);
+	for (ishard = 0; ishard < group->num_shards; ++ishard)
+		mutex_unlock(group->shards[ishard].lock);
+	for (ishard = 0; ishard < group->num_shards; ++ishard) {
+		if (!thread_start(&group->shards[ishard].thread)) {
+			log_errorf(HASH_NETWORK, ERROR_SYSTEM_CALL_FAIL,
+			           STRING_CONST("Network poll group: Unable to start shard %" PRIsize " worker"), ishard);
+			network_poll_group_stop(group);
+			return false;
+		}
+	}
+	return true;
+}
+
+void
+network_poll_group_stop(network_poll_group_t* group) {
+	size_t ishard;
+	atomic_store32(&group->running, 0, memory_order_release);
+	for (ishard = 0; ishard < group->num_shards; ++ishard)
+		network_poll_wakeup(group->shards[ishard].poll);
+	for (ishard = 0; ishard < group->num_shards; ++ishard) {
+		network_poll_shard_t* shard = group->shards + ishard;
+		if (thread_is_started(&shard->thread))
+			thread_join(&shard->thread);
+	}
+	//Sockets queued after the workers exited are registered immediately
+	for (ishard = 0; ishard < group->num_shards; ++ishard) {
+		network_poll_shard_t* shard = group->shards + ishard;
+		mutex_lock(shard->lock);
+		_network_poll_apply_queue(shard->poll);
+		mutex_unlock(shard->lock);
+		network_poll_shard_publish_load(shard);
+	}
+}
+
+void*
+network_poll_group_context(const network_poll_group_t* group) {
+	return group->context;
+}
+
+size_t
+network_poll_group_num_polls(const network_poll_group_t* group) {
+	return group->num_shards;
+}
+
+network_poll_t*
+network_poll_group_poll(network_poll_group_t* group, size_t index) {
+	return (index < group->num_shards) ? group->shards[index].poll : nullptr;
+}
+
+size_t
+network_poll_group_add_socket(network_poll_group_t* group, socket_t* sock) {
+	size_t ishard, best = 0;
+	int32_t best_load = atomic_load32(&group->shards[0].load, memory_order_acquire);
+	for (ishard = 1; ishard < group->num_shards; ++ishard) {
+		int32_t load = atomic_load32(&group->shards[ishard].load, memory_order_acquire);
+		if (load < best_load) {
+			best = ishard;
+			best_load = load;
+		}
+	}
+	network_poll_group_enqueue(group, best, sock);
+	return best;
+}
+
+size_t
+network_poll_group_add_socket_hashed(network_poll_group_t* group, socket_t* sock, hash_t key) {
+	size_t index = (size_t)(key % group->num_shards);
+	network_poll_group_enqueue(group, index, sock);
+	return index;
+}
+
+void
+network_poll_group_remove_socket(network_poll_group_t* group, socket_t* sock) {
+	size_t index = network_poll_group_shard_index(group, sock->poll);
+	if (index < group->num_shards) {
+		network_poll_remove_socket(group->shards[index].poll, sock);
+		atomic_decr32(&group->shards[index].load, memory_order_release);
+	}
+}
+
+void
+network_poll_group_migrate_socket(network_poll_group_t* group, socket_t* sock, size_t index) {
+	size_t current = network_poll_group_shard_index(group, sock->poll);
+	if ((index >= group->num_shards) || (current == index))
+		return;
+	network_poll_group_remove_socket(group, sock);
+	network_poll_group_enqueue(group, index, sock);
+}
@@ -0,0 +1,106 @@
+/* pollgroup.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file pollgroup.h
+    Sharded socket polling driven by a set of worker threads. Each shard owns a
+    network poll and a worker thread pinned to a hardware thread. Sockets are
+    owned by the worker of the shard they are assigned to, and the group handler
+    is called on that worker thread with the events of the shard poll. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Allocate a poll group
+\param num_polls Number of shards (polls and worker threads), 0 for one per hardware thread
+\param num_sockets Initial socket capacity of each shard poll
+\param handler Event handler, called on the shard worker thread
+\param context User context, available through #network_poll_group_context
+\return New poll group, worker threads not started */
+NETWORK_API network_poll_group_t*
+network_poll_group_allocate(size_t num_polls, unsigned int num_sockets,
+                            network_poll_group_fn handler, void* context);
+
+/*! Stop the worker threads and deallocate the poll group. Sockets remaining in the
+shard polls are not deallocated.
+\param group Poll group */
+NETWORK_API void
+network_poll_group_deallocate(network_poll_group_t* group);
+
+/*! Start the worker threads
+\param group Poll group
+\param timeoutms Maximum time a worker waits in #network_poll, can be NETWORK_TIMEOUT_INFINITE
+                 as workers are woken up by added sockets and stop requests
+\return true if started, false if error */
+NETWORK_API bool
+network_poll_group_start(network_poll_group_t* group, unsigned int timeoutms);
+
+/*! Stop the worker threads and wait for them to exit
+\param group Poll group */
+NETWORK_API void
+network_poll_group_stop(network_poll_group_t* group);
+
+/*! Query user context
+\param group Poll group
+\return User context given at allocation */
+NETWORK_API void*
+network_poll_group_context(const network_poll_group_t* group);
+
+/*! Query number of shards
+\param group Poll group
+\return Number of shards */
+NETWORK_API size_t
+network_poll_group_num_polls(const network_poll_group_t* group);
+
+/*! Get the poll of a shard. The poll must only be accessed from the worker
+thread of the shard, or while the group is stopped.
+\param group Poll group
+\param index Shard index
+\return Poll of shard */
+NETWORK_API network_poll_t*
+network_poll_group_poll(network_poll_group_t* group, size_t index);
+
+/*! Add a socket to the least loaded shard. Thread safe, the socket is
+registered by the shard worker, which is woken up if waiting, or immediately
+if the group is stopped. Deallocating the socket before it is registered
+discards the request.
+\param group Poll group
+\param sock Socket
+\return Index of shard the socket was assigned to */
+NETWORK_API size_t
+network_poll_group_add_socket(network_poll_group_t* group, socket_t* sock);
+
+/*! Add a socket to the shard given by a hash key, keeping related sockets
+(for example from the same remote address) on the same worker. Thread safe.
+\param group Poll group
+\param sock Socket
+\param key Hash key
+\return Index of shard the socket was assigned to */
+NETWORK_API size_t
+network_poll_group_add_socket_hashed(network_poll_group_t* group, socket_t* sock, hash_t key);
+
+/*! Remove a socket from its shard. Must be called from the worker thread owning
+the socket (from the handler), or while the group is stopped.
+\param group Poll group
+\param sock Socket */
+NETWORK_API void
+network_poll_group_remove_socket(network_poll_group_t* group, socket_t* sock);
+
+/*! Migrate a socket to another shard. Must be called from the worker thread owning
+the socket (from the handler), or while the group is stopped. The socket is owned
+by the target shard worker once the call returns.
+\param group Poll group
+\param sock Socket
+\param index Target shard index */
+NETWORK_API void
+network_poll_group_migrate_socket(network_poll_group_t* group, socket_t* sock, size_t index);
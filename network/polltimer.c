@@ -0,0 +1,428 @@
+/* polltimer.c  -  Network library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#include <network/polltimer.h>
+#include <network/poll.h>
+#include <network/internal.h>
+
+#include <foundation/foundation.h>
+
+#if FOUNDATION_COMPILER_MSVC
+#  include <intrin.h>
+#endif
+
+//Hierarchical timer wheel with millisecond resolution. Level n buckets span 64^n
+//milliseconds, timers are cascaded to lower levels as the wheel time reaches their bucket.
+//Timers are nodes in a pool addressed by one-based index, linked into buckets by index.
+
+#define NETWORK_POLL_TIMER_BITS    6
+#define NETWORK_POLL_TIMER_MASK    (NETWORK_POLL_TIMER_SLOTS - 1)
+#define NETWORK_POLL_TIMER_EXPIRED (NETWORK_POLL_TIMER_LEVELS * NETWORK_POLL_TIMER_SLOTS)
+#define NETWORK_POLL_TIMER_NONE    0
+#define NETWORK_POLL_TIMER_FREED   ((unsigned int)-1)
+#define NETWORK_POLL_TIMER_USER    -1
+
+//Index of the lowest set bit, mask must be non-zero
+static unsigned int
+network_poll_timers_first_bit(uint64_t mask) {
+#if FOUNDATION_COMPILER_MSVC
+	//Scanned as two halves, 64-bit scan is not available on 32-bit targets
+	unsigned long index = 0;
+	if (_BitScanForward(&index, (unsigned long)(mask & 0xFFFFFFFFULL)))
+		return (unsigned int)index;
+	_BitScanForward(&index, (unsigned long)(mask >> 32ULL));
+	return (unsigned int)index + 32;
+#else
+	return (unsigned int)__builtin_ctzll(mask);
+#endif
+}
+
+static uint64_t
+network_poll_timers_current(network_poll_timers_t* timers) {
+	return (uint64_t)((time_current() - timers->base) / timers->ticks_per_ms);
+}
+
+static network_poll_timers_t*
+network_poll_timers(network_poll_t* pollobj) {
+	network_poll_timers_t* timers = pollobj->timers;
+	if (!timers) {
+		timers = memory_allocate(HASH_NETWORK, sizeof(network_poll_timers_t), 0,
+		                         MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+		timers->ticks_per_ms = time_ticks_per_second() / 1000;
+		if (!timers->ticks_per_ms)
+			timers->ticks_per_ms = 1;
+		timers->base = time_current();
+		pollobj->timers = timers;
+	}
+	return timers;
+}
+
+static void
+network_poll_timers_link(network_poll_timers_t* timers, unsigned int index, unsigned int bucket) {
+	network_poll_timer_t* timer = timers->nodes + (index - 1);
+	timer->bucket = bucket;
+	timer->prev = NETWORK_POLL_TIMER_NONE;
+	timer->next = timers->heads[bucket];
+	if (timer->next)
+		timers->nodes[timer->next - 1].prev = index;
+	timers->heads[bucket] = index;
+	if (bucket < NETWORK_POLL_TIMER_EXPIRED)
+		timers->occupied[bucket / NETWORK_POLL_TIMER_SLOTS] |=
+		    ((uint64_t)1 << (bucket & NETWORK_POLL_TIMER_MASK));
+}
+
+static void
+network_poll_timers_unlink(network_poll_timers_t* timers, unsigned int index) {
+	network_poll_timer_t* timer = timers->nodes + (index - 1);
+	unsigned int bucket = timer->bucket;
+	if (timer->prev)
+		timers->nodes[timer->prev - 1].next = timer->next;
+	else
+		timers->heads[bucket] = timer->next;
+	if (timer->next)
+		timers->nodes[timer->next - 1].prev = timer->prev;
+	if (!timers->heads[bucket] && (bucket < NETWORK_POLL_TIMER_EXPIRED))
+		timers->occupied[bucket / NETWORK_POLL_TIMER_SLOTS] &=
+		    ~((uint64_t)1 << (bucket & NETWORK_POLL_TIMER_MASK));
+	timer->next = timer->prev = NETWORK_POLL_TIMER_NONE;
+}
+
+static void
+network_poll_timers_insert(network_poll_timers_t* timers, unsigned int index) {
+	network_poll_timer_t* timer = timers->nodes + (index - 1);
+	uint64_t deadline = timer->deadline;
+	unsigned int level;
+	if (deadline <= timers->now) {
+		network_poll_timers_link(timers, index, NETWORK_POLL_TIMER_EXPIRED);
+		return;
+	}
+	for (level = 0; level < NETWORK_POLL_TIMER_LEVELS - 1; ++level) {
+		unsigned int shift = level * NETWORK_POLL_TIMER_BITS;
+		if ((deadline >> shift) - (timers->now >> shift) < NETWORK_POLL_TIMER_SLOTS)
+			break;
+	}
+	if (level == NETWORK_POLL_TIMER_LEVELS - 1) {
+		//Beyond the wheel range timers wait in the last bucket of the top level and are re-cascaded
+		unsigned int shift = level * NETWORK_POLL_TIMER_BITS;
+		uint64_t limit = (timers->now >> shift) + NETWORK_POLL_TIMER_SLOTS - 1;
+		if ((deadline >> shift) > limit)
+			deadline = limit << shift;
+	}
+	network_poll_timers_link(timers, index, (level * NETWORK_POLL_TIMER_SLOTS) +
+	                         (unsigned int)((deadline >> (level * NETWORK_POLL_TIMER_BITS)) & NETWORK_POLL_TIMER_MASK));
+}
+
+static unsigned int
+network_poll_timers_allocate(network_poll_timers_t* timers, int type, socket_t* sock, void* data,
+                             unsigned int timeoutms, unsigned int intervalms) {
+	network_poll_timer_t* timer;
+	unsigned int index = timers->free;
+	if (index != NETWORK_POLL_TIMER_NONE) {
+		timers->free = timers->nodes[index - 1].next;
+	}
+	else {
+		network_poll_timer_t newtimer;
+		memset(&newtimer, 0, sizeof(newtimer));
+		array_push(timers->nodes, newtimer);
+		index = (unsigned int)array_size(timers->nodes);
+	}
+	timer = timers->nodes + (index - 1);
+	timer->deadline = timers->now + timeoutms;
+	timer->interval = intervalms;
+	timer->type = type;
+	timer->sock = sock;
+	timer->data = data;
+	network_poll_timers_insert(timers, index);
+	++timers->count;
+	return index;
+}
+
+static void
+network_poll_timers_deallocate(network_poll_timers_t* timers, unsigned int index) {
+	network_poll_timer_t* timer = timers->nodes + (index - 1);
+	network_poll_timers_unlink(timers, index);
+	timer->bucket = NETWORK_POLL_TIMER_FREED;
+	timer->sock = nullptr;
+	timer->data = nullptr;
+	timer->next = timers->free;
+	timers->free = index;
+	--timers->count;
+}
+
+static void
+network_poll_timers_expire_bucket(network_poll_timers_t* timers, unsigned int bucket) {
+	unsigned int index = timers->heads[bucket];
+	while (index) {
+		unsigned int next = timers->nodes[index - 1].next;
+		network_poll_timers_unlink(timers, index);
+		network_poll_timers_link(timers, index, NETWORK_POLL_TIMER_EXPIRED);
+		index = next;
+	}
+}
+
+static void
+network_poll_timers_cascade_bucket(network_poll_timers_t* timers, unsigned int bucket) {
+	unsigned int index = timers->heads[bucket];
+	while (index) {
+		unsigned int next = timers->nodes[index - 1].next;
+		network_poll_timers_unlink(timers, index);
+		network_poll_timers_insert(timers, index);
+		index = next;
+	}
+}
+
+static void
+network_poll_timers_advance(network_poll_timers_t* timers, uint64_t target) {
+	while (timers->now < target) {
+		uint64_t tick;
+		unsigned int level;
+
+		if (!timers->count) {
+			timers->now = target;
+			break;
+		}
+
+		//Skip to the end of the current level 0 span if no timers are left in it
+		tick = timers->now + 1;
+		if (tick & NETWORK_POLL_TIMER_MASK) {
+			uint64_t remain = timers->occupied[0] & ~(((uint64_t)1 << (tick & NETWORK_POLL_TIMER_MASK)) - 1);
+			if (!remain) {
+				uint64_t end = timers->now | NETWORK_POLL_TIMER_MASK;
+				timers->now = (end < target) ? end : target;
+				continue;
+			}
+		}
+
+		//Cascade higher levels from the top down when the tick starts a new span
+		for (level = 1; level < NETWORK_POLL_TIMER_LEVELS; ++level) {
+			if (tick & (((uint64_t)1 << (level * NETWORK_POLL_TIMER_BITS)) - 1))
+				break;
+		}
+		timers->now = tick;
+		while (--level > 0) {
+			unsigned int slot = (unsigned int)((tick >> (level * NETWORK_POLL_TIMER_BITS)) & NETWORK_POLL_TIMER_MASK);
+			network_poll_timers_cascade_bucket(timers, (level * NETWORK_POLL_TIMER_SLOTS) + slot);
+		}
+
+		network_poll_timers_expire_bucket(timers, (unsigned int)(tick & NETWORK_POLL_TIMER_MASK));
+	}
+}
+
+static uint64_t
+network_poll_timers_next(network_poll_timers_t* timers) {
+	uint64_t next = (uint64_t)-1;
+	unsigned int level;
+	if (timers->heads[NETWORK_POLL_TIMER_EXPIRED])
+		return timers->now;
+	for (level = 0; level < NETWORK_POLL_TIMER_LEVELS; ++level) {
+		unsigned int shift = level * NETWORK_POLL_TIMER_BITS;
+		uint64_t occupied = timers->occupied[level];
+		uint64_t span = timers->now >> shift;
+		unsigned int first, distance;
+		uint64_t rotated;
+		if (!occupied)
+			continue;
+		//Distance in buckets from the one following the current, rotated to start there
+		first = (unsigned int)((span + 1) & NETWORK_POLL_TIMER_MASK);
+		rotated = first ? ((occupied >> first) | (occupied << (NETWORK_POLL_TIMER_SLOTS - first))) : occupied;
+		distance = network_poll_timers_first_bit(rotated);
+		if (!level) {
+			uint64_t deadline = timers->now + 1 + distance;
+			if (deadline < next)
+				next = deadline;
+		}
+		else {
+			//Higher levels need processing when the wheel reaches the start of the bucket span
+			uint64_t start = (span + 1 + distance) << shift;
+			if (start < next)
+				next = start;
+		}
+	}
+	return next;
+}
+
+void
+_network_poll_timers_finalize(network_poll_t* pollobj) {
+	network_poll_timers_t* timers = pollobj->timers;
+	if (!timers)
+		return;
+	array_deallocate(timers->nodes);
+	memory_deallocate(timers);
+	pollobj->timers = nullptr;
+}
+
+unsigned int
+_network_poll_timers_update(network_poll_t* pollobj, unsigned int timeoutms) {
+	network_poll_timers_t* timers = pollobj->timers;
+	uint64_t current, next;
+	if (!timers)
+		return timeoutms;
+	current = network_poll_timers_current(timers);
+	network_poll_timers_advance(timers, current);
+	if (!timers->count)
+		return timeoutms;
+	next = network_poll_timers_next(timers);
+	if (next <= current)
+		return 0;
+	if ((timeoutms == NETWORK_TIMEOUT_INFINITE) || (next - current < timeoutms))
+		return (unsigned int)(next - current);
+	return timeoutms;
+}
+
+size_t
+_network_poll_timers_expired(network_poll_t* pollobj, network_poll_event_t* events, size_t capacity) {
+	network_poll_timers_t* timers = pollobj->timers;
+	size_t num_events = 0;
+	unsigned int index;
+	if (!timers)
+		return 0;
+	while ((num_events < capacity) && (index = timers->heads[NETWORK_POLL_TIMER_EXPIRED])) {
+		network_poll_timer_t* timer = timers->nodes + (index - 1);
+		network_poll_event_t* event = events + num_events++;
+		if (timer->type == NETWORK_POLL_TIMER_USER) {
+			event->event = NETWORKEVENT_TIMER;
+			event->socket = nullptr;
+			event->buffer = timer->data;
+			event->result = (int)index;
+			if (timer->interval) {
+				network_poll_timers_unlink(timers, index);
+				timer->deadline += timer->interval;
+				if (timer->deadline <= timers->now)
+					timer->deadline = timers->now + timer->interval;
+				network_poll_timers_insert(timers, index);
+				continue;
+			}
+		}
+		else {
+			event->event = NETWORKEVENT_TIMEOUT;
+			event->socket = timer->sock;
+			event->buffer = nullptr;
+			event->result = timer->type;
+			pollobj->slots[timer->sock->poll_slot].deadline[timer->type] = NETWORK_POLL_TIMER_NONE;
+		}
+		network_poll_timers_deallocate(timers, index);
+	}
+	return num_events;
+}
+
+void
+_network_poll_timers_socket_events(network_poll_t* pollobj, const network_poll_event_t* events,
+                                   size_t num_events) {
+	network_poll_timers_t* timers = pollobj->timers;
+	size_t ievt;
+	if (!timers || !timers->count)
+		return;
+	for (ievt = 0; ievt < num_events; ++ievt) {
+		socket_t* sock = events[ievt].socket;
+		network_poll_slot_t* slot;
+		if (!sock || (sock->poll != pollobj))
+			continue;
+		slot = pollobj->slots + sock->poll_slot;
+		switch (events[ievt].event) {
+		case NETWORKEVENT_CONNECTION:
+		case NETWORKEVENT_DATAIN:
+		case NETWORKEVENT_READ_COMPLETE:
+			if (slot->deadline[NETWORK_DEADLINE_READ]) {
+				network_poll_timers_deallocate(timers, slot->deadline[NETWORK_DEADLINE_READ]);
+				slot->deadline[NETWORK_DEADLINE_READ] = NETWORK_POLL_TIMER_NONE;
+			}
+			break;
+		case NETWORKEVENT_DATAOUT:
+		case NETWORKEVENT_WRITE_COMPLETE:
+		case NETWORKEVENT_SEND_COMPLETE:
+		case NETWORKEVENT_OUTPUT_LOW:
+			if (slot->deadline[NETWORK_DEADLINE_WRITE]) {
+				network_poll_timers_deallocate(timers, slot->deadline[NETWORK_DEADLINE_WRITE]);
+				slot->deadline[NETWORK_DEADLINE_WRITE] = NETWORK_POLL_TIMER_NONE;
+			}
+			break;
+		case NETWORKEVENT_CONNECTED:
+			if (slot->deadline[NETWORK_DEADLINE_CONNECT]) {
+				network_poll_timers_deallocate(timers, slot->deadline[NETWORK_DEADLINE_CONNECT]);
+				slot->deadline[NETWORK_DEADLINE_CONNECT] = NETWORK_POLL_TIMER_NONE;
+			}
+			break;
+		default:
+			break;
+		}
+		//Any activity pushes the idle deadline forward
+		if (slot->deadline[NETWORK_DEADLINE_IDLE]) {
+			unsigned int index = slot->deadline[NETWORK_DEADLINE_IDLE];
+			network_poll_timer_t* timer = timers->nodes + (index - 1);
+			if (timer->bucket != NETWORK_POLL_TIMER_EXPIRED) {
+				network_poll_timers_unlink(timers, index);
+				timer->deadline = timers->now + timer->interval;
+				network_poll_timers_insert(timers, index);
+			}
+		}
+	}
+}
+
+void
+_network_poll_timers_remove_socket(network_poll_t* pollobj, network_poll_slot_t* slot) {
+	unsigned int itype;
+	if (!pollobj->timers)
+		return;
+	for (itype = 0; itype < NETWORK_DEADLINE_COUNT; ++itype) {
+		if (slot->deadline[itype]) {
+			network_poll_timers_deallocate(pollobj->timers, slot->deadline[itype]);
+			slot->deadline[itype] = NETWORK_POLL_TIMER_NONE;
+		}
+	}
+}
+
+void
+network_poll_set_deadline(network_poll_t* pollobj, socket_t* sock, network_deadline_t type,
+                          unsigned int timeoutms) {
+	network_poll_timers_t* timers;
+	network_poll_slot_t* slot;
+	if ((sock->poll != pollobj) || (type >= NETWORK_DEADLINE_COUNT))
+		return;
+	slot = pollobj->slots + sock->poll_slot;
+	if (!timeoutms && !slot->deadline[type])
+		return;
+	timers = network_poll_timers(pollobj);
+	if (slot->deadline[type]) {
+		network_poll_timers_deallocate(timers, slot->deadline[type]);
+		slot->deadline[type] = NETWORK_POLL_TIMER_NONE;
+	}
+	if (timeoutms) {
+		network_poll_timers_advance(timers, network_poll_timers_current(timers));
+		//The idle deadline keeps its timeout as interval to be pushed forward on activity
+		slot->deadline[type] = network_poll_timers_allocate(timers, (int)type, sock, nullptr, timeoutms,
+		                                                    (type == NETWORK_DEADLINE_IDLE) ? timeoutms : 0);
+	}
+}
+
+unsigned int
+network_poll_add_timer(network_poll_t* pollobj, unsigned int timeoutms, unsigned int intervalms,
+                       void* data) {
+	network_poll_timers_t* timers = network_poll_timers(pollobj);
+	network_poll_timers_advance(timers, network_poll_timers_current(timers));
+	return network_poll_timers_allocate(timers, NETWORK_POLL_TIMER_USER, nullptr, data, timeoutms,
+	                                    intervalms);
+}
+
+void
+network_poll_remove_timer(network_poll_t* pollobj, unsigned int timer) {
+	network_poll_timers_t* timers = pollobj->timers;
+	if (!timers || !timer || (timer > array_size(timers->nodes)))
+		return;
+	if ((timers->nodes[timer - 1].type != NETWORK_POLL_TIMER_USER) ||
+	    (timers->nodes[timer - 1].bucket == NETWORK_POLL_TIMER_FREED))
+		return;
+	network_poll_timers_deallocate(timers, timer);
+}
+
+size_t
+network_poll_num_timers(const network_poll_t* pollobj) {
+	return pollobj->timers ? pollobj->timers->count : 0;
+}
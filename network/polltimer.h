@@ -0,0 +1,59 @@
+/* polltimer.h  -  Network library  -  Public Domain  -  2013 Mattias Jansson / Rampant Pixels
+ *
+ * This library provides a network abstraction built on foundation streams. The latest source code is
+ * always available at
+ *
+ * https://github.com/rampantpixels/network_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file polltimer.h
+    Timers and socket deadlines driven by a network poll. Timers are kept in a
+    hierarchical timer wheel with millisecond resolution, and the poll wait is bounded
+    by the nearest deadline. Expired timers are returned from #network_poll as
+    NETWORKEVENT_TIMER events, expired socket deadlines as NETWORKEVENT_TIMEOUT events
+    with the deadline type as event result. */
+
+#include <foundation/platform.h>
+
+#include <network/types.h>
+
+/*! Set a deadline for a socket in the poll, replacing any previous deadline of the same
+type. A read deadline is cleared by incoming data or connections, a write deadline by
+the socket becoming writable, and a connect deadline by the connection completing. An
+idle deadline is pushed forward by any event on the socket. Deadlines are one-shot and
+cleared when the socket is removed from the poll.
+\param poll Poll
+\param sock Socket
+\param type Deadline type
+\param timeoutms Timeout in milliseconds, 0 to clear the deadline */
+NETWORK_API void
+network_poll_set_deadline(network_poll_t* poll, socket_t* sock, network_deadline_t type,
+                          unsigned int timeoutms);
+
+/*! Add a user timer to the poll
+\param poll Poll
+\param timeoutms Time in milliseconds until the timer first expires
+\param intervalms Interval in milliseconds for repeating timers, 0 for a one-shot timer
+\param data User data, returned as buffer in the timer event
+\return Timer id, returned as result in the timer event. The id of a one-shot timer
+        is invalid once the timer has expired */
+NETWORK_API unsigned int
+network_poll_add_timer(network_poll_t* poll, unsigned int timeoutms, unsigned int intervalms,
+                       void* data);
+
+/*! Remove a user timer from the poll
+\param poll Poll
+\param timer Timer id */
+NETWORK_API void
+network_poll_remove_timer(network_poll_t* poll, unsigned int timer);
+
+/*! Query number of active timers and socket deadlines in the poll
+\param poll Poll
+\return Number of timers */
+NETWORK_API size_t
+network_poll_num_timers(const network_poll_t* poll);
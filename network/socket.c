@@ -10,15 +10,215 @@
  */
 
 #include <network/socket.h>
+#include <network/poll.h>
 #include <network/address.h>
 #include <network/internal.h>
 #include <network/hashstrings.h>
 
 #include <foundation/foundation.h>
 
+#if FOUNDATION_PLATFORM_POSIX
+#  include <sys/uio.h>
+#  include <unistd.h>
+#endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+#  include <sys/sendfile.h>
+#elif FOUNDATION_PLATFORM_WINDOWS
+#  include <io.h>
+#endif
+
+//Maximum number of io vectors passed to a single system call
+#define NETWORK_SOCKET_IOV_BATCH 64
+
+//Size of the intermediate buffer when a file cannot be sent by the kernel
+#define NETWORK_SOCKET_FILE_CHUNK 16384
+
+//Blocks carved from each slab of a socket pool
+#define NETWORK_SOCKET_POOL_SLAB 256
+//Blocks kept in a thread cache before a batch is returned to the shared list
+#define NETWORK_SOCKET_POOL_CACHE 512
+//Blocks moved between a thread cache and the shared list at a time
+#define NETWORK_SOCKET_POOL_BATCH 64
+
+//Largest buffer size representable as a socket option value
+#define NETWORK_SOCKET_BUFFER_MAX 0x7FFFFFFF
+
+typedef struct socket_pool_block_t socket_pool_block_t;
+
+struct socket_pool_block_t {
+	socket_pool_block_t* next;
+};
+
+//Fixed size blocks carved from slabs owned by the pool. Threads allocate from and recycle
+//to a thread local cache without locking, the shared list under the lock only balances
+//caches of threads allocating and deallocating sockets in different amounts
+typedef struct socket_pool_t {
+	size_t block_size;
+	mutex_t* lock;
+	void** slabs;
+	socket_pool_block_t* shared;
+	unsigned int num_shared;
+} socket_pool_t;
+
+static socket_pool_t _socket_pool;
+//Generation of the pools, thread caches of an earlier module initialization are discarded
+static unsigned int _socket_pool_generation;
+
+FOUNDATION_DECLARE_THREAD_LOCAL(socket_pool_block_t*, socket_cache, 0)
+FOUNDATION_DECLARE_THREAD_LOCAL(unsigned int, socket_cache_count, 0)
+FOUNDATION_DECLARE_THREAD_LOCAL(unsigned int, socket_cache_generation, 0)
+
 static void
 _socket_set_blocking_fd(int fd, bool block);
 
+static void
+_socket_pool_initialize_pool(socket_pool_t* pool, size_t block_size) {
+	memset(pool, 0, sizeof(socket_pool_t));
+	pool->block_size = (block_size + 15) & ~(size_t)15;
+	pool->lock = mutex_allocate(STRING_CONST("socket_pool"));
+}
+
+static void
+_socket_pool_finalize_pool(socket_pool_t* pool) {
+	size_t islab, ssize;
+	for (islab = 0, ssize = array_size(pool->slabs); islab < ssize; ++islab)
+		memory_deallocate(pool->slabs[islab]);
+	array_deallocate(pool->slabs);
+	mutex_deallocate(pool->lock);
+	memset(pool, 0, sizeof(socket_pool_t));
+}
+
+//Move a batch of blocks from the shared list to a thread cache, carving a new slab if empty
+static socket_pool_block_t*
+_socket_pool_refill(socket_pool_t* pool, unsigned int* count) {
+	socket_pool_block_t* first;
+	socket_pool_block_t* last;
+	unsigned int num_blocks = 0;
+
+	mutex_lock(pool->lock);
+	if (!pool->shared) {
+		void* slab = memory_allocate(HASH_NETWORK, pool->block_size * NETWORK_SOCKET_POOL_SLAB, 16,
+		                             MEMORY_PERSISTENT);
+		unsigned int iblock;
+		for (iblock = 0; iblock < NETWORK_SOCKET_POOL_SLAB; ++iblock) {
+			socket_pool_block_t* block = pointer_offset(slab, pool->block_size * iblock);
+			block->next = pool->shared;
+			pool->shared = block;
+		}
+		pool->num_shared += NETWORK_SOCKET_POOL_SLAB;
+		array_push(pool->slabs, slab);
+	}
+	first = last = pool->shared;
+	while (++num_blocks < NETWORK_SOCKET_POOL_BATCH && last->next)
+		last = last->next;
+	pool->shared = last->next;
+	pool->num_shared -= num_blocks;
+	mutex_unlock(pool->lock);
+
+	last->next = nullptr;
+	*count = num_blocks;
+	return first;
+}
+
+//Return a batch of blocks from the head of a thread cache to the shared list
+static socket_pool_block_t*
+_socket_pool_spill(socket_pool_t* pool, socket_pool_block_t* cache, unsigned int* count) {
+	socket_pool_block_t* last = cache;
+	socket_pool_block_t* remain;
+	unsigned int num_blocks = 1;
+	while (num_blocks < NETWORK_SOCKET_POOL_BATCH) {
+		last = last->next;
+		++num_blocks;
+	}
+
+	mutex_lock(pool->lock);
+	remain = last->next;
+	last->next = pool->shared;
+	pool->shared = cache;
+	pool->num_shared += num_blocks;
+	mutex_unlock(pool->lock);
+
+	*count -= num_blocks;
+	return remain;
+}
+
+static void
+_socket_pool_validate_cache(void) {
+	if (get_thread_socket_cache_generation() != _socket_pool_generation) {
+		set_thread_socket_cache(nullptr);
+		set_thread_socket_cache_count(0);
+		set_thread_socket_cache_generation(_socket_pool_generation);
+	}
+}
+
+void
+_socket_pool_initialize(void) {
+	++_socket_pool_generation;
+	_socket_pool_initialize_pool(&_socket_pool, sizeof(socket_t));
+}
+
+void
+_socket_pool_finalize(void) {
+	_socket_pool_finalize_pool(&_socket_pool);
+	++_socket_pool_generation;
+}
+
+//Return the whole thread cache to the shared list, blocks cached by a thread exiting without
+//this stay out of use until the module is finalized, at most NETWORK_SOCKET_POOL_CACHE
+void
+_socket_pool_thread_finalize(void) {
+	socket_pool_block_t* cache;
+	socket_pool_block_t* last;
+	unsigned int count;
+
+	_socket_pool_validate_cache();
+	cache = get_thread_socket_cache();
+	count = get_thread_socket_cache_count();
+	if (!cache)
+		return;
+	for (last = cache; last->next; last = last->next)
+		;
+
+	mutex_lock(_socket_pool.lock);
+	last->next = _socket_pool.shared;
+	_socket_pool.shared = cache;
+	_socket_pool.num_shared += count;
+	mutex_unlock(_socket_pool.lock);
+
+	set_thread_socket_cache(nullptr);
+	set_thread_socket_cache_count(0);
+}
+
+socket_t*
+_socket_allocate(void) {
+	socket_pool_block_t* block;
+	unsigned int count;
+
+	_socket_pool_validate_cache();
+	block = get_thread_socket_cache();
+	count = get_thread_socket_cache_count();
+	if (!block)
+		block = _socket_pool_refill(&_socket_pool, &count);
+	set_thread_socket_cache(block->next);
+	set_thread_socket_cache_count(count - 1);
+
+	return (socket_t*)block;
+}
+
+static void
+_socket_deallocate(socket_t* sock) {
+	socket_pool_block_t* block = (socket_pool_block_t*)sock;
+	unsigned int count;
+
+	_socket_pool_validate_cache();
+	count = get_thread_socket_cache_count() + 1;
+	block->next = get_thread_socket_cache();
+	if (count > NETWORK_SOCKET_POOL_CACHE)
+		block = _socket_pool_spill(&_socket_pool, block, &count);
+	set_thread_socket_cache(block);
+	set_thread_socket_cache_count(count);
+}
+
 void
 _socket_initialize(socket_t* sock) {
 	memset(sock, 0, sizeof(socket_t));
@@ -45,6 +245,12 @@ _socket_create_fd(socket_t* sock, network_address_family_t family) {
 		socket_set_blocking(sock, sock->flags & SOCKETFLAG_BLOCKING);
 		socket_set_reuse_address(sock, sock->flags & SOCKETFLAG_REUSE_ADDR);
 		socket_set_reuse_port(sock, sock->flags & SOCKETFLAG_REUSE_PORT);
+		if (sock->send_buffer)
+			socket_set_send_buffer_size(sock, sock->send_buffer);
+		if (sock->receive_buffer)
+			socket_set_receive_buffer_size(sock, sock->receive_buffer);
+		if (sock->tos)
+			socket_set_tos(sock, sock->tos);
 	}
 
 	return sock->fd;
@@ -54,7 +260,14 @@ void
 socket_finalize(socket_t* sock) {
 	log_debugf(HASH_NETWORK, STRING_CONST("Finalizing socket (0x%" PRIfixPTR " : %d)"),
 	           (uintptr_t)sock, sock->fd);
+	//Requests not yet applied must not reach the poll thread after the socket is freed
+	if (sock->poll_queued)
+		_network_poll_queue_purge(sock->poll_queued, sock);
+	if (sock->poll)
+		network_poll_remove_socket(sock->poll, sock);
 	socket_close(sock);	
+	array_deallocate(sock->zerocopy);
+	array_deallocate(sock->output);
 #if FOUNDATION_PLATFORM_WINDOWS
 	if (sock->event)
 		CloseHandle(sock->event);
@@ -66,7 +279,7 @@ socket_deallocate(socket_t* sock) {
 	if (!sock)
 		return;
 	socket_finalize(sock);
-	memory_deallocate(sock);
+	_socket_deallocate(sock);
 }
 
 network_socket_type_t
@@ -86,13 +299,13 @@ socket_bind(socket_t* sock, const network_address_t* address) {
 
 	address_ip = (const network_address_ip_t*)address;
 	if (bind(sock->fd, &address_ip->saddr, (socklen_t)address_ip->address_size) == 0) {
-		//Store local address
-		_socket_store_address_local(sock, (int)address_ip->family);
+		//Local address with any assigned port is resolved on demand
+		_socket_defer_address_local(sock);
 		success = true;
 #if BUILD_ENABLE_LOG
 		{
 			char buffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
-			string_t address_str = network_address_to_string(buffer, sizeof(buffer), sock->address_local, true);
+			string_t address_str = network_address_to_string(buffer, sizeof(buffer), socket_address_local(sock), true);
 			log_infof(HASH_NETWORK, STRING_CONST("Bound socket (0x%" PRIfixPTR " : %d) to local address %.*s"),
 			          (uintptr_t)sock, sock->fd, STRING_FORMAT(address_str));
 		}
@@ -152,19 +365,7 @@ _socket_connect(socket_t* sock, const network_address_t* address, unsigned int t
 				failed = false;
 			}
 			else {
-				struct timeval tv;
-				fd_set fdwrite, fderr;
-				int ret;
-
-				FD_ZERO(&fdwrite);
-				FD_ZERO(&fderr);
-				FD_SET(sock->fd, &fdwrite);
-				FD_SET(sock->fd, &fderr);
-
-				tv.tv_sec  = timeoutms / 1000;
-				tv.tv_usec = (timeoutms % 1000) * 1000;
-
-				ret = select((int)(sock->fd + 1), 0, &fdwrite, &fderr, (timeoutms != NETWORK_TIMEOUT_INFINITE) ? &tv : nullptr);
+				int ret = _socket_poll_fd(sock->fd, NETWORK_POLLFD_WRITE, timeoutms);
 				if (ret > 0) {
 #if FOUNDATION_PLATFORM_WINDOWS
 					int serr = 0;
@@ -175,22 +376,22 @@ _socket_connect(socket_t* sock, const network_address_t* address, unsigned int t
 					socklen_t slen = sizeof(int);
 					getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
 #endif
-					if (!serr && !FD_ISSET(sock->fd, &fderr)) {
+					if (!serr && !(ret & (NETWORK_POLLFD_ERROR | NETWORK_POLLFD_HANGUP))) {
 						failed = false;
-						if (FD_ISSET(sock->fd, &fdwrite))
+						if (ret & NETWORK_POLLFD_WRITE)
 							sock->state = SOCKETSTATE_CONNECTED;
 					}
 					else {
 						err = serr;
 #if BUILD_ENABLE_DEBUG_LOG
-						error_message = string_const(STRING_CONST("select indicated socket error"));
+						error_message = string_const(STRING_CONST("poll indicated socket error"));
 #endif
 					}
 				}
 				else if (ret < 0) {
 					err = NETWORK_SOCKET_ERROR;
 #if BUILD_ENABLE_DEBUG_LOG
-					error_message = string_const(STRING_CONST("select failed"));
+					error_message = string_const(STRING_CONST("poll failed"));
 #endif
 				}
 				else {
@@ -200,7 +401,7 @@ _socket_connect(socket_t* sock, const network_address_t* address, unsigned int t
 					err = ETIMEDOUT;
 #endif
 #if BUILD_ENABLE_DEBUG_LOG
-					error_message = string_const(STRING_CONST("select timed out"));
+					error_message = string_const(STRING_CONST("poll timed out"));
 #endif
 				}
 			}
@@ -227,11 +428,10 @@ _socket_connect(socket_t* sock, const network_address_t* address, unsigned int t
 		return err;
 	}
 
-	memory_deallocate(sock->address_remote);
-	sock->address_remote = network_address_clone(address);
+	_socket_set_address_remote(sock, address);
 
-	if (!sock->address_local)
-		_socket_store_address_local(sock, (int)address_ip->family);
+	if (!_socket_has_address_local(sock))
+		_socket_defer_address_local(sock);
 
 #if BUILD_ENABLE_DEBUG_LOG
 	{
@@ -286,8 +486,7 @@ socket_connect(socket_t* sock, const network_address_t* address, unsigned int ti
 		return false;
 	}
 
-	memory_deallocate(sock->address_remote);
-	sock->address_remote = network_address_clone(address);
+	_socket_set_address_remote(sock, address);
 
 	return true;
 }
@@ -364,6 +563,76 @@ socket_set_reuse_port(socket_t* sock, bool reuse) {
 #endif
 }
 
+bool
+_socket_set_option(socket_t* sock, int level, int name, int value, const char* option, size_t length) {
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return true;
+	if (setsockopt(sock->fd, level, name, (const char*)&value, sizeof(value)) < 0) {
+		const int sockerr = NETWORK_SOCKET_ERROR;
+		const string_const_t errmsg = system_error_message(sockerr);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Unable to set %.*s option on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+		          (int)length, option, (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+		return false;
+	}
+	return true;
+}
+
+//Query the buffer size in use by an open socket, or the configured size
+static size_t
+_socket_buffer_size(const socket_t* sock, int name, unsigned int configured) {
+	int value = 0;
+#if FOUNDATION_PLATFORM_WINDOWS
+	int len = sizeof(value);
+#else
+	socklen_t len = sizeof(value);
+#endif
+	if ((sock->fd != NETWORK_SOCKET_INVALID) &&
+	    (getsockopt(sock->fd, SOL_SOCKET, name, (char*)&value, &len) == 0) && (value > 0))
+		return (size_t)value;
+	return configured;
+}
+
+size_t
+socket_send_buffer_size(const socket_t* sock) {
+	return _socket_buffer_size(sock, SO_SNDBUF, sock->send_buffer);
+}
+
+bool
+socket_set_send_buffer_size(socket_t* sock, size_t size) {
+	sock->send_buffer = (size < NETWORK_SOCKET_BUFFER_MAX) ? (unsigned int)size : NETWORK_SOCKET_BUFFER_MAX;
+	if (!sock->send_buffer)
+		return true;
+	return _socket_set_option(sock, SOL_SOCKET, SO_SNDBUF, (int)sock->send_buffer, STRING_CONST("send buffer"));
+}
+
+size_t
+socket_receive_buffer_size(const socket_t* sock) {
+	return _socket_buffer_size(sock, SO_RCVBUF, sock->receive_buffer);
+}
+
+bool
+socket_set_receive_buffer_size(socket_t* sock, size_t size) {
+	sock->receive_buffer = (size < NETWORK_SOCKET_BUFFER_MAX) ? (unsigned int)size : NETWORK_SOCKET_BUFFER_MAX;
+	if (!sock->receive_buffer)
+		return true;
+	return _socket_set_option(sock, SOL_SOCKET, SO_RCVBUF, (int)sock->receive_buffer,
+	                          STRING_CONST("receive buffer"));
+}
+
+unsigned int
+socket_tos(const socket_t* sock) {
+	return sock->tos;
+}
+
+bool
+socket_set_tos(socket_t* sock, unsigned int tos) {
+	sock->tos = tos & 0xFF;
+	if (sock->family == NETWORK_ADDRESSFAMILY_IPV6)
+		return _socket_set_option(sock, IPPROTO_IPV6, IPV6_TCLASS, (int)sock->tos, STRING_CONST("traffic class"));
+	return _socket_set_option(sock, IPPROTO_IP, IP_TOS, (int)sock->tos, STRING_CONST("type of service"));
+}
+
 bool
 socket_set_multicast_group(socket_t* sock, network_address_t* address, bool allow_loopback) {
 	unsigned char ttl = 1;
@@ -395,12 +664,23 @@ socket_set_multicast_group(socket_t* sock, network_address_t* address, bool allo
 
 const network_address_t*
 socket_address_local(const socket_t* sock) {
-	return sock->address_local;
+	//Resolving on demand caches the address in the socket
+	if (sock->flags & SOCKETFLAG_ADDRESS_LOCAL_LAZY) {
+		socket_t* resolve = (socket_t*)sock;
+		resolve->flags &= ~SOCKETFLAG_ADDRESS_LOCAL_LAZY;
+		if ((sock->fd != NETWORK_SOCKET_INVALID) &&
+		    _socket_address_initialize(&resolve->address_local, (int)sock->family)) {
+			if (getsockname(sock->fd, &resolve->address_local.ip.saddr,
+			                &resolve->address_local.base.address_size) != 0)
+				resolve->address_local.base.address_size = 0;
+		}
+	}
+	return sock->address_local.base.address_size ? &sock->address_local.base : nullptr;
 }
 
 const network_address_t*
 socket_address_remote(const socket_t* sock) {
-	return sock->address_remote;
+	return sock->address_remote.base.address_size ? &sock->address_remote.base : nullptr;
 }
 
 socket_state_t
@@ -410,32 +690,32 @@ socket_state(const socket_t* sock) {
 
 socket_state_t
 socket_poll_state(socket_t* sock) {
-	struct timeval tv;
-	fd_set fdwrite, fderr;
 	int available;
+	int ready;
 
 	if ((sock->state == SOCKETSTATE_NOTCONNECTED) || (sock->state == SOCKETSTATE_DISCONNECTED))
 		return sock->state;
 
+	//The owning poll closes connected sockets on error or hangup, and moves them to
+	//disconnected on peer shutdown while data is left to read
+	if (sock->poll && (sock->state == SOCKETSTATE_CONNECTED))
+		return sock->state;
+
 	switch (sock->state) {
 	case SOCKETSTATE_CONNECTING:
-		FD_ZERO(&fdwrite);
-		FD_ZERO(&fderr);
-		FD_SET(sock->fd, &fdwrite);
-		FD_SET(sock->fd, &fderr);
-
-		tv.tv_sec  = 0;
-		tv.tv_usec = 0;
-
-		select((int)(sock->fd + 1), 0, &fdwrite, &fderr, &tv);
+		ready = _socket_poll_fd(sock->fd, NETWORK_POLLFD_WRITE, 0);
+		if (ready < 0)
+			break;
 
-		if (FD_ISSET(sock->fd, &fderr)) {
+		if (ready & (NETWORK_POLLFD_ERROR | NETWORK_POLLFD_HANGUP)) {
 			log_debugf(HASH_NETWORK,
 			           STRING_CONST("Socket (0x%" PRIfixPTR " : %d): error in state CONNECTING"),
 			           (uintptr_t)sock, sock->fd);
+			if (sock->poll)
+				_network_poll_push(sock->poll, NETWORKEVENT_ERROR, sock, 0);
 			socket_close(sock);
 		}
-		else if (FD_ISSET(sock->fd, &fdwrite)) {
+		else if (ready & NETWORK_POLLFD_WRITE) {
 #if BUILD_ENABLE_DEBUG_LOG
 			log_debugf(HASH_NETWORK,
 			           STRING_CONST("Socket (0x%" PRIfixPTR " : %d): CONNECTING -> CONNECTED"),
@@ -444,6 +724,11 @@ socket_poll_state(socket_t* sock) {
 			sock->state = SOCKETSTATE_CONNECTED;
 			if (sock->beacon)
 				socket_set_beacon(sock, sock->beacon);
+			//Owning poll reports the connection as if it had completed it
+			if (sock->poll) {
+				_network_poll_push(sock->poll, NETWORKEVENT_CONNECTED, sock, 0);
+				network_poll_update_socket(sock->poll, sock);
+			}
 		}
 		break;
 
@@ -482,6 +767,11 @@ socket_fd(socket_t* sock) {
 	return sock->fd;
 }
 
+bool
+socket_drained(const socket_t* sock) {
+	return ((sock->flags & SOCKETFLAG_DRAINED) != 0);
+}
+
 size_t
 socket_available_read(const socket_t* sock) {
 	return (sock->fd != NETWORK_SOCKET_INVALID) ?
@@ -489,6 +779,104 @@ socket_available_read(const socket_t* sock) {
 		0;
 }
 
+//Handle a failed or zero-length receive, closing the socket on graceful close or fatal error
+static void
+_socket_read_failed(socket_t* sock, long ret) {
+	if (ret == 0) {
+#if BUILD_ENABLE_DEBUG_LOG
+		char addrbuffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
+		string_t address_str = network_address_to_string(addrbuffer, sizeof(addrbuffer),
+		                                                 socket_address_remote(sock), true);
+		log_debugf(HASH_NETWORK,
+		           STRING_CONST("Socket closed gracefully on remote end (0x%" PRIfixPTR " : %d): %.*s"),
+		           (uintptr_t)sock, sock->fd, STRING_FORMAT(address_str));
+#endif
+		socket_close(sock);
+	}
+	else {
+		int sockerr = NETWORK_SOCKET_ERROR;
+#if FOUNDATION_PLATFORM_WINDOWS
+		if (sockerr == WSAEWOULDBLOCK)
+#else
+		if (sockerr == EAGAIN)
+#endif
+		{
+			sock->flags |= SOCKETFLAG_DRAINED;
+			return;
+		}
+		else {
+			string_const_t errmsg = system_error_message(sockerr);
+			log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+			          STRING_CONST("Socket recv() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+			          (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+		}
+
+#if FOUNDATION_PLATFORM_WINDOWS
+		if ((sockerr == WSAENETDOWN) || (sockerr == WSAENETRESET) || (sockerr == WSAENOTCONN) ||
+		        (sockerr == WSAECONNABORTED) || (sockerr == WSAECONNRESET) || (sockerr == WSAETIMEDOUT))
+#else
+		if ((sockerr == ECONNRESET) || (sockerr == EPIPE) || (sockerr == ETIMEDOUT))
+#endif
+		{
+			socket_close(sock);
+		}
+
+		socket_poll_state(sock);
+	}
+}
+
+//Handle a failed send, closing the socket on fatal error. A full send buffer is the
+//normal case for non-blocking sockets and returns without further system calls
+void
+_socket_write_failed(socket_t* sock, size_t total_write, size_t size) {
+	int sockerr = NETWORK_SOCKET_ERROR;
+	int serr = 0;
+#if FOUNDATION_PLATFORM_WINDOWS
+	int slen = sizeof(int);
+#else
+	socklen_t slen = sizeof(int);
+#endif
+
+#if FOUNDATION_PLATFORM_WINDOWS
+	if (sockerr == WSAEWOULDBLOCK)
+#else
+	if (sockerr == EAGAIN)
+#endif
+	{
+#if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 0
+		log_debugf(HASH_NETWORK,
+		           STRING_CONST("Partial socket send() on (0x%" PRIfixPTR
+		                        " : %d): %" PRIsize" of %" PRIsize " bytes written to socket"),
+		           (uintptr_t)sock, sock->fd, total_write, size);
+#else
+		FOUNDATION_UNUSED(total_write);
+		FOUNDATION_UNUSED(size);
+#endif
+		return;
+	}
+
+	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
+	{
+		const string_const_t errstr = system_error_message(sockerr);
+		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+		          STRING_CONST("Socket send() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d) (SO_ERROR %d)"),
+		          (uintptr_t)sock, sock->fd, STRING_FORMAT(errstr), sockerr, serr);
+	}
+
+#if FOUNDATION_PLATFORM_WINDOWS
+	if ((sockerr == WSAENETDOWN) || (sockerr == WSAENETRESET) || (sockerr == WSAENOTCONN) ||
+	        (sockerr == WSAECONNABORTED) || (sockerr == WSAECONNRESET) || (sockerr == WSAETIMEDOUT))
+#else
+	if ((sockerr == ECONNRESET) || (sockerr == EPIPE) || (sockerr == ETIMEDOUT))
+#endif
+	{
+		socket_close(sock);
+	}
+
+	if (sock->state != SOCKETSTATE_NOTCONNECTED)
+		socket_poll_state(sock);
+}
+
 size_t
 socket_read(socket_t* sock, void* buffer, size_t size) {
 	size_t read;
@@ -527,58 +915,21 @@ socket_read(socket_t* sock, void* buffer, size_t size) {
 
 		read = (size_t)ret;
 		sock->bytes_read += read;
+		sock->flags &= ~SOCKETFLAG_DRAINED;
 
 		return read;
 	}
 
-	if (ret == 0) {
-#if BUILD_ENABLE_DEBUG_LOG
-		char addrbuffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
-		string_t address_str = network_address_to_string(addrbuffer, sizeof(addrbuffer),
-		                                                 sock->address_remote, true);
-		log_debugf(HASH_NETWORK,
-		           STRING_CONST("Socket closed gracefully on remote end (0x%" PRIfixPTR " : %d): %.*s"),
-		           (uintptr_t)sock, sock->fd, STRING_FORMAT(address_str));
-#endif
-		socket_close(sock);
-	}
-	else {
-		int sockerr = NETWORK_SOCKET_ERROR;
-#if FOUNDATION_PLATFORM_WINDOWS
-		if (sockerr != WSAEWOULDBLOCK)
-#else
-		if (sockerr != EAGAIN)
-#endif
-		{
-			string_const_t errmsg = system_error_message(sockerr);
-			log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
-			          STRING_CONST("Socket recv() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
-			          (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
-		}
-
-#if FOUNDATION_PLATFORM_WINDOWS
-		if ((sockerr == WSAENETDOWN) || (sockerr == WSAENETRESET) || (sockerr == WSAENOTCONN) ||
-		        (sockerr == WSAECONNABORTED) || (sockerr == WSAECONNRESET) || (sockerr == WSAETIMEDOUT))
-#else
-		if ((sockerr == ECONNRESET) || (sockerr == EPIPE) || (sockerr == ETIMEDOUT))
-#endif
-		{
-			socket_close(sock);
-		}
-
-		socket_poll_state(sock);
-	}
+	_socket_read_failed(sock, ret);
 
 	return 0;
 }
 
-size_t
-socket_write(socket_t* sock, const void* buffer, size_t size) {
+//Send data until all is written or the socket would block or fails
+static size_t
+_socket_send(socket_t* sock, const void* buffer, size_t size) {
 	size_t total_write = 0;
 
-	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
-		return 0;
-
 	while (total_write < size) {
 		const char* current = (const char*)pointer_offset_const(buffer, total_write);
 		size_t remain = size - total_write;
@@ -612,49 +963,338 @@ socket_write(socket_t* sock, const void* buffer, size_t size) {
 			total_write += (unsigned long)res;
 		}
 		else if (res <= 0) {
-			int sockerr = NETWORK_SOCKET_ERROR;
+			_socket_write_failed(sock, total_write, size);
+			break;
+		}
+	}
+
+	sock->bytes_written += total_write;
+
+	return total_write;
+}
+
+static size_t
+_socket_output_size(const socket_t* sock) {
+	return array_size(sock->output) - sock->output_offset;
+}
+
+//Append unsent data to the output queue, reclaiming space of sent data once it is
+//larger than the data still queued
+static void
+_socket_output_append(socket_t* sock, const void* buffer, size_t size) {
+	size_t queued = _socket_output_size(sock);
+	size_t end;
+	if (sock->output_offset && (sock->output_offset >= queued)) {
+		memmove(sock->output, sock->output + sock->output_offset, queued);
+		array_resize(sock->output, queued);
+		sock->output_offset = 0;
+	}
+	end = array_size(sock->output);
+	array_resize(sock->output, end + size);
+	memcpy(sock->output + end, buffer, size);
+}
+
+//Arm write interest for queued output and notify crossing the high watermark
+static void
+_socket_output_queued(socket_t* sock) {
+	if (!(sock->flags & SOCKETFLAG_OUTPUT_QUEUED)) {
+		sock->flags |= SOCKETFLAG_OUTPUT_QUEUED;
+		if (sock->poll)
+			network_poll_update_socket(sock->poll, sock);
+	}
+	if (!(sock->flags & SOCKETFLAG_OUTPUT_HIGH) && sock->output_high &&
+	    (_socket_output_size(sock) >= sock->output_high)) {
+		sock->flags |= SOCKETFLAG_OUTPUT_HIGH;
+		if (sock->poll)
+			_network_poll_push(sock->poll, NETWORKEVENT_OUTPUT_HIGH, sock, (int)_socket_output_size(sock));
+	}
+}
+
+size_t
+_socket_output_flush(socket_t* sock) {
+	size_t queued = _socket_output_size(sock);
+	size_t written;
+	if (!queued)
+		return 0;
+	written = _socket_send(sock, sock->output + sock->output_offset, queued);
+	//A failed socket is closed, discarding the queue
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return 0;
+	if (written < queued) {
+		sock->output_offset += written;
+		return queued - written;
+	}
+	array_clear(sock->output);
+	sock->output_offset = 0;
+	sock->flags &= ~SOCKETFLAG_OUTPUT_QUEUED;
+	return 0;
+}
+
+size_t
+socket_write(socket_t* sock, const void* buffer, size_t size) {
+	size_t written = 0;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
+		return 0;
+
+	if (!sock->output_high && !(sock->flags & SOCKETFLAG_OUTPUT_QUEUED))
+		return _socket_send(sock, buffer, size);
+
+	//Data is sent directly only if nothing is queued ahead of it, the rest is queued
+	if (!(sock->flags & SOCKETFLAG_OUTPUT_QUEUED))
+		written = _socket_send(sock, buffer, size);
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return written;
+	if (written < size) {
+		_socket_output_append(sock, pointer_offset_const(buffer, written), size - written);
+		_socket_output_queued(sock);
+	}
+	return size;
+}
 
+//Gather a batch of io vectors starting at an offset into the first vector and transfer
+//them in a single system call, returns bytes transferred or negative on error
+static long
+_socket_transfer_iov(int fd, const network_iovec_t* iov, size_t count, size_t offset, bool send) {
+	size_t ivec;
+	size_t num = (count < NETWORK_SOCKET_IOV_BATCH) ? count : NETWORK_SOCKET_IOV_BATCH;
 #if FOUNDATION_PLATFORM_WINDOWS
-			int serr = 0;
-			int slen = sizeof(int);
-			getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
+	WSABUF vec[NETWORK_SOCKET_IOV_BATCH];
+	DWORD transferred = 0;
+	DWORD flags = 0;
+	int ret;
+	for (ivec = 0; ivec < num; ++ivec) {
+		vec[ivec].buf = (CHAR*)iov[ivec].base;
+		vec[ivec].len = (ULONG)iov[ivec].size;
+	}
+	vec[0].buf += offset;
+	vec[0].len -= (ULONG)offset;
+	if (send)
+		ret = WSASend((SOCKET)fd, vec, (DWORD)num, &transferred, 0, nullptr, nullptr);
+	else
+		ret = WSARecv((SOCKET)fd, vec, (DWORD)num, &transferred, &flags, nullptr, nullptr);
+	return (ret == 0) ? (long)transferred : -1;
 #else
-			int serr = 0;
-			socklen_t slen = sizeof(int);
-			getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
+	struct iovec vec[NETWORK_SOCKET_IOV_BATCH];
+	struct msghdr msg;
+	for (ivec = 0; ivec < num; ++ivec) {
+		vec[ivec].iov_base = iov[ivec].base;
+		vec[ivec].iov_len = iov[ivec].size;
+	}
+	vec[0].iov_base = pointer_offset(vec[0].iov_base, offset);
+	vec[0].iov_len -= offset;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = vec;
+	msg.msg_iovlen = num;
+	return (long)(send ? sendmsg(fd, &msg, 0) : recvmsg(fd, &msg, 0));
 #endif
+}
 
-#if FOUNDATION_PLATFORM_WINDOWS
-			if (sockerr == WSAEWOULDBLOCK)
-#else
-			if (sockerr == EAGAIN)
+size_t
+socket_readv(socket_t* sock, const network_iovec_t* iov, size_t count) {
+	size_t read;
+	long ret;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !network_iovec_size(iov, count))
+		return 0;
+
+	ret = _socket_transfer_iov(sock->fd, iov, count, 0, false);
+	if (ret > 0) {
+#if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 0
+		log_debugf(HASH_NETWORK,
+		           STRING_CONST("Socket (0x%" PRIfixPTR " : %d) read %d bytes to %" PRIsize " buffers"),
+		           (uintptr_t)sock, sock->fd, (int)ret, count);
 #endif
-			{
-				log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
-				          STRING_CONST("Partial socket send() on (0x%" PRIfixPTR
-				                       " : %d): %" PRIsize" of %" PRIsize " bytes written to socket (SO_ERROR %d)"),
-				          (uintptr_t)sock, sock->fd, total_write, size, serr);
-			}
-			else {
-				const string_const_t errstr = system_error_message(sockerr);
-				log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
-				          STRING_CONST("Socket send() failed on socket (0x%" PRIfixPTR " : %d): %.*s (%d) (SO_ERROR %d)"),
-				          (uintptr_t)sock, sock->fd, STRING_FORMAT(errstr), sockerr, serr);
+		read = (size_t)ret;
+		sock->bytes_read += read;
+		sock->flags &= ~SOCKETFLAG_DRAINED;
+
+		return read;
+	}
+
+	_socket_read_failed(sock, ret);
+
+	return 0;
+}
+
+//Send buffers until all is written or the socket would block or fails
+static size_t
+_socket_sendv(socket_t* sock, const network_iovec_t* iov, size_t count, size_t size) {
+	size_t total_write = 0;
+	size_t ivec = 0;
+	size_t offset = 0;
+
+	while (total_write < size) {
+		long res;
+
+		//Skip consumed and empty vectors
+		while ((ivec < count) && (offset >= iov[ivec].size)) {
+			offset -= iov[ivec].size;
+			++ivec;
+		}
+
+		res = _socket_transfer_iov(sock->fd, iov + ivec, count - ivec, offset, true);
+		if (res > 0) {
+#if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 0
+			log_debugf(HASH_NETWORK,
+			           STRING_CONST("Socket (0x%" PRIfixPTR " : %d) wrote %d of %" PRIsize " bytes (offset %" PRIsize ")"),
+			           (uintptr_t)sock, sock->fd, (int)res, size - total_write, total_write);
+#endif
+			total_write += (size_t)res;
+			offset += (size_t)res;
+		}
+		else {
+			_socket_write_failed(sock, total_write, size);
+			break;
+		}
+	}
+
+	sock->bytes_written += total_write;
+
+	return total_write;
+}
+
+size_t
+socket_writev(socket_t* sock, const network_iovec_t* iov, size_t count) {
+	size_t size = network_iovec_size(iov, count);
+	size_t written = 0;
+	size_t ivec;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
+		return 0;
+
+	if (!sock->output_high && !(sock->flags & SOCKETFLAG_OUTPUT_QUEUED))
+		return _socket_sendv(sock, iov, count, size);
+
+	if (!(sock->flags & SOCKETFLAG_OUTPUT_QUEUED))
+		written = _socket_sendv(sock, iov, count, size);
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return written;
+	if (written < size) {
+		size_t skip = written;
+		for (ivec = 0; ivec < count; ++ivec) {
+			if (skip >= iov[ivec].size) {
+				skip -= iov[ivec].size;
+				continue;
 			}
+			_socket_output_append(sock, pointer_offset_const(iov[ivec].base, skip), iov[ivec].size - skip);
+			skip = 0;
+		}
+		_socket_output_queued(sock);
+	}
+	return size;
+}
+
+void
+socket_set_output_queue(socket_t* sock, size_t high, size_t low) {
+	sock->output_high = high;
+	sock->output_low = (low < high) ? low : high;
+}
+
+size_t
+socket_output_queued(const socket_t* sock) {
+	return _socket_output_size(sock);
+}
+
+size_t
+socket_flush_output(socket_t* sock) {
+	size_t queued;
+	if (!(sock->flags & SOCKETFLAG_OUTPUT_QUEUED))
+		return 0;
+	queued = _socket_output_flush(sock);
+	if ((sock->flags & SOCKETFLAG_OUTPUT_HIGH) && (queued <= sock->output_low)) {
+		sock->flags &= ~SOCKETFLAG_OUTPUT_HIGH;
+		if (sock->poll)
+			_network_poll_push(sock->poll, NETWORKEVENT_OUTPUT_LOW, sock, (int)queued);
+	}
+	if (!(sock->flags & SOCKETFLAG_OUTPUT_QUEUED) && sock->poll)
+		network_poll_update_socket(sock->poll, sock);
+	return queued;
+}
 
+//Read a file chunk at an offset, returns bytes read, 0 at end of file or -1 on error
+static long
+_socket_read_file(int fd, void* buffer, size_t size, size_t offset) {
 #if FOUNDATION_PLATFORM_WINDOWS
-			if ((sockerr == WSAENETDOWN) || (sockerr == WSAENETRESET) || (sockerr == WSAENOTCONN) ||
-			        (sockerr == WSAECONNABORTED) || (sockerr == WSAECONNRESET) || (sockerr == WSAETIMEDOUT))
+	OVERLAPPED overlapped;
+	DWORD num_read = 0;
+	memset(&overlapped, 0, sizeof(overlapped));
+	overlapped.Offset = (DWORD)((uint64_t)offset & 0xFFFFFFFF);
+	overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+	if (!ReadFile((HANDLE)_get_osfhandle(fd), buffer, (DWORD)size, &num_read, &overlapped))
+		return (GetLastError() == ERROR_HANDLE_EOF) ? 0 : -1;
+	return (long)num_read;
 #else
-			if ((sockerr == ECONNRESET) || (sockerr == EPIPE) || (sockerr == ETIMEDOUT))
+	return (long)pread(fd, buffer, size, (off_t)offset);
 #endif
-			{
-				socket_close(sock);
+}
+
+//Send a file through user space, for descriptors the kernel cannot send directly
+static size_t
+_socket_send_file_copy(socket_t* sock, int fd, size_t offset, size_t size) {
+	char buffer[NETWORK_SOCKET_FILE_CHUNK];
+	size_t total_write = 0;
+
+	while (total_write < size) {
+		size_t chunk = size - total_write;
+		size_t written;
+		long res;
+		if (chunk > sizeof(buffer))
+			chunk = sizeof(buffer);
+		res = _socket_read_file(fd, buffer, chunk, offset + total_write);
+		if (res <= 0) {
+			if (res < 0) {
+				const int err = system_error();
+				const string_const_t errmsg = system_error_message(err);
+				log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+				          STRING_CONST("Unable to read file %d for socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+				          fd, (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), err);
 			}
+			break;
+		}
+		//Data read but not sent is read again by the next call at the returned offset
+		written = socket_write(sock, buffer, (size_t)res);
+		total_write += written;
+		if (written < (size_t)res)
+			break;
+	}
+
+	return total_write;
+}
+
+size_t
+socket_send_file(socket_t* sock, int fd, size_t offset, size_t size) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	size_t total_write = 0;
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
+		return 0;
 
-			if (sock->state != SOCKETSTATE_NOTCONNECTED)
-				socket_poll_state(sock);
+	//Queued output must be sent first, socket_write queues the file data behind it
+	if (sock->flags & SOCKETFLAG_OUTPUT_QUEUED)
+		return _socket_send_file_copy(sock, fd, offset, size);
 
+	while (total_write < size) {
+		off_t position = (off_t)(offset + total_write);
+		long res = (long)sendfile(sock->fd, fd, &position, size - total_write);
+		if (res > 0) {
+#if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 0
+			log_debugf(HASH_NETWORK,
+			           STRING_CONST("Socket (0x%" PRIfixPTR " : %d) sent %d of %" PRIsize " bytes from file %d (offset %" PRIsize ")"),
+			           (uintptr_t)sock, sock->fd, (int)res, size - total_write, fd, offset + total_write);
+#endif
+			total_write += (size_t)res;
+		}
+		else if (!res) {
+			//End of file
+			break;
+		}
+		else if (!total_write && ((errno == EINVAL) || (errno == ENOSYS))) {
+			//Descriptor type not supported by sendfile, socket_write tracks sent bytes
+			return _socket_send_file_copy(sock, fd, offset, size);
+		}
+		else {
+			_socket_write_failed(sock, total_write, size);
 			break;
 		}
 	}
@@ -662,6 +1302,36 @@ socket_write(socket_t* sock, const void* buffer, size_t size) {
 	sock->bytes_written += total_write;
 
 	return total_write;
+#else
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
+		return 0;
+	return _socket_send_file_copy(sock, fd, offset, size);
+#endif
+}
+
+size_t
+network_iovec_size(const network_iovec_t* iov, size_t count) {
+	size_t size = 0;
+	size_t ivec;
+	for (ivec = 0; ivec < count; ++ivec)
+		size += iov[ivec].size;
+	return size;
+}
+
+size_t
+network_iovec_advance(network_iovec_t* iov, size_t count, size_t bytes) {
+	size_t ivec = 0;
+	while ((ivec < count) && (bytes >= iov[ivec].size)) {
+		bytes -= iov[ivec].size;
+		iov[ivec].base = pointer_offset(iov[ivec].base, iov[ivec].size);
+		iov[ivec].size = 0;
+		++ivec;
+	}
+	if ((ivec < count) && bytes) {
+		iov[ivec].base = pointer_offset(iov[ivec].base, bytes);
+		iov[ivec].size -= bytes;
+	}
+	return ivec;
 }
 
 //Returns -1 if nothing available and socket closed, 0 if nothing available but still open, >0 if data available
@@ -690,21 +1360,74 @@ _socket_available_fd(int fd) {
 	return (!available && closed) ? -1 : available;
 }
 
+//Wait for readiness of a single descriptor without the FD_SETSIZE limit of select, returns
+//a mask of NETWORK_POLLFD_* flags, 0 on timeout or negative on error
+int
+_socket_poll_fd(int fd, unsigned int events, unsigned int timeoutms) {
+	int ready = 0;
+	int ret;
+#if FOUNDATION_PLATFORM_WINDOWS
+	WSAPOLLFD pfd;
+	pfd.fd = (SOCKET)fd;
+	pfd.events = (short)(((events & NETWORK_POLLFD_READ) ? POLLRDNORM : 0) |
+	                     ((events & NETWORK_POLLFD_WRITE) ? POLLWRNORM : 0));
+	pfd.revents = 0;
+	ret = WSAPoll(&pfd, 1, (timeoutms != NETWORK_TIMEOUT_INFINITE) ? (INT)timeoutms : -1);
+#else
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = (short)(((events & NETWORK_POLLFD_READ) ? POLLIN : 0) |
+	                     ((events & NETWORK_POLLFD_WRITE) ? POLLOUT : 0));
+	pfd.revents = 0;
+	ret = poll(&pfd, 1, (timeoutms != NETWORK_TIMEOUT_INFINITE) ? (int)timeoutms : -1);
+#endif
+	if (ret <= 0)
+		return ret;
+	if (pfd.revents & (POLLIN | POLLRDNORM))
+		ready |= NETWORK_POLLFD_READ;
+	if (pfd.revents & (POLLOUT | POLLWRNORM))
+		ready |= NETWORK_POLLFD_WRITE;
+	if (pfd.revents & (POLLERR | POLLNVAL))
+		ready |= NETWORK_POLLFD_ERROR;
+	if (pfd.revents & POLLHUP)
+		ready |= NETWORK_POLLFD_HANGUP;
+	return ready;
+}
+
 void
 socket_close(socket_t* sock) {
 	int fd = NETWORK_SOCKET_INVALID;
-	network_address_t* local_address = sock->address_local;
-	network_address_t* remote_address = sock->address_remote;
 
 	if (sock->fd != NETWORK_SOCKET_INVALID) {
 		fd = sock->fd;
 		sock->fd    = NETWORK_SOCKET_INVALID;
 		sock->state = SOCKETSTATE_NOTCONNECTED;
+		sock->flags &= ~SOCKETFLAG_DRAINED;
 		sock->family = 0;
 	}
 
-	sock->address_local  = nullptr;
-	sock->address_remote = nullptr;
+	//The kernel drops the poll registration with the descriptor, a reopened socket
+	//reusing the same descriptor number must be registered again
+	if (sock->poll) {
+		network_poll_slot_t* slot = sock->poll->slots + sock->poll_slot;
+		slot->fd = NETWORK_SOCKET_INVALID;
+		slot->mask = 0;
+	}
+
+	//Completions of pending zero-copy sends are not observed for a closed socket
+	if (sock->poll)
+		_network_poll_zerocopy_cancel(sock->poll, sock, false);
+	array_clear(sock->zerocopy);
+	sock->zerocopy_next = 0;
+
+	//Queued output is discarded
+	array_clear(sock->output);
+	sock->output_offset = 0;
+	sock->flags &= ~(SOCKETFLAG_OUTPUT_QUEUED | SOCKETFLAG_OUTPUT_HIGH);
+
+	sock->flags &= ~SOCKETFLAG_ADDRESS_LOCAL_LAZY;
+	sock->address_local.base.address_size  = 0;
+	sock->address_remote.base.address_size = 0;
 
 	if (fd != NETWORK_SOCKET_INVALID) {
 		log_debugf(HASH_NETWORK, STRING_CONST("Closing socket (0x%" PRIfixPTR " : %d)"),
@@ -712,11 +1435,6 @@ socket_close(socket_t* sock) {
 		_socket_set_blocking_fd(fd, false);
 		_socket_close_fd(fd);
 	}
-
-	if (local_address)
-		memory_deallocate(local_address);
-	if (remote_address)
-		memory_deallocate(remote_address);
 }
 
 void
@@ -745,36 +1463,39 @@ _socket_set_blocking_fd(int fd, bool block) {
 #endif
 }
 
-void
-_socket_store_address_local(socket_t* sock, int family) {
-	network_address_ip_t* address_local = 0;
-
-	FOUNDATION_ASSERT(sock);
-	if (sock->fd == NETWORK_SOCKET_INVALID)
-		return;
-
+bool
+_socket_address_initialize(network_address_storage_t* address, int family) {
+	memset(address, 0, sizeof(network_address_storage_t));
 	if (family == NETWORK_ADDRESSFAMILY_IPV4) {
-		address_local = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv4_t), 0,
-		                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
-		address_local->family = NETWORK_ADDRESSFAMILY_IPV4;
-		address_local->address_size = sizeof(struct sockaddr_in);
+		address->base.family = NETWORK_ADDRESSFAMILY_IPV4;
+		address->base.address_size = sizeof(struct sockaddr_in);
 	}
 	else if (family == NETWORK_ADDRESSFAMILY_IPV6) {
-		address_local = memory_allocate(HASH_NETWORK, sizeof(network_address_ipv6_t), 0,
-		                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
-		address_local->family = NETWORK_ADDRESSFAMILY_IPV6;
-		address_local->address_size = sizeof(struct sockaddr_in6);
+		address->base.family = NETWORK_ADDRESSFAMILY_IPV6;
+		address->base.address_size = sizeof(struct sockaddr_in6);
 	}
 	else {
-		FOUNDATION_ASSERT_FAILFORMAT_LOG(HASH_NETWORK,
-		                                 "Unable to get local address for socket (0x%" PRIfixPTR
-		                                 " : %d): Unsupported address family %u",
-		                                 (uintptr_t)sock, sock->fd, family);
-		return;
+		FOUNDATION_ASSERT_FAILFORMAT_LOG(HASH_NETWORK, "Unsupported address family %u", family);
+		return false;
 	}
-	getsockname(sock->fd, &address_local->saddr, (socklen_t*)&address_local->address_size);
-	memory_deallocate(sock->address_local);
-	sock->address_local = (network_address_t*)address_local;
+	return true;
+}
+
+void
+_socket_set_address_remote(socket_t* sock, const network_address_t* address) {
+	FOUNDATION_ASSERT(sizeof(network_address_t) + address->address_size <= sizeof(network_address_storage_t));
+	memcpy(&sock->address_remote, address, sizeof(network_address_t) + address->address_size);
+}
+
+void
+_socket_defer_address_local(socket_t* sock) {
+	sock->address_local.base.address_size = 0;
+	sock->flags |= SOCKETFLAG_ADDRESS_LOCAL_LAZY;
+}
+
+bool
+_socket_has_address_local(const socket_t* sock) {
+	return (sock->address_local.base.address_size != 0) || ((sock->flags & SOCKETFLAG_ADDRESS_LOCAL_LAZY) != 0);
 }
 
 void
@@ -54,6 +54,51 @@ socket_reuse_port(const socket_t* sock);
 NETWORK_API void
 socket_set_reuse_port(socket_t* sock, bool reuse);
 
+/*! Query send buffer size. For an open socket this is the size used by the system,
+which on Linux is twice the requested size to account for bookkeeping overhead.
+\param sock Socket
+\return Send buffer size in bytes, 0 if not open and not configured */
+NETWORK_API size_t
+socket_send_buffer_size(const socket_t* sock);
+
+/*! Set send buffer size (SO_SNDBUF). The size is kept and applied again if the socket
+descriptor is recreated. Set before connecting or listening to let the system scale the
+TCP window accordingly.
+\param sock Socket
+\param size Buffer size in bytes, 0 to keep the system default for new descriptors
+\return true if successful, false if error */
+NETWORK_API bool
+socket_set_send_buffer_size(socket_t* sock, size_t size);
+
+/*! Query receive buffer size, see #socket_send_buffer_size
+\param sock Socket
+\return Receive buffer size in bytes, 0 if not open and not configured */
+NETWORK_API size_t
+socket_receive_buffer_size(const socket_t* sock);
+
+/*! Set receive buffer size (SO_RCVBUF), see #socket_set_send_buffer_size
+\param sock Socket
+\param size Buffer size in bytes, 0 to keep the system default for new descriptors
+\return true if successful, false if error */
+NETWORK_API bool
+socket_set_receive_buffer_size(socket_t* sock, size_t size);
+
+/*! Query type of service byte of outgoing packets
+\param sock Socket
+\return Type of service, 0 if not configured */
+NETWORK_API unsigned int
+socket_tos(const socket_t* sock);
+
+/*! Set type of service byte of outgoing packets (IP_TOS, or IPV6_TCLASS for IPv6
+sockets). The DSCP code point is the upper six bits, for example 46 (expedited
+forwarding) is set as 46 << 2. The value is kept and applied again if the socket
+descriptor is recreated.
+\param sock Socket
+\param tos Type of service
+\return true if successful, false if error */
+NETWORK_API bool
+socket_set_tos(socket_t* sock, unsigned int tos);
+
 NETWORK_API bool
 socket_set_multicast_group(socket_t* sock, network_address_t* address, bool allow_loopback);
 
@@ -75,12 +120,99 @@ socket_fd(socket_t* sock);
 NETWORK_API size_t
 socket_available_read(const socket_t* sock);
 
+/*! Query if the last read or accept on the socket would have blocked, meaning all
+pending data was consumed. Used to drive edge-triggered polls, where a socket must be
+drained before the next NETWORKEVENT_DATAIN or NETWORKEVENT_CONNECTION is delivered.
+The flag is cleared when new data is read or the poll reports the socket readable.
+\param sock Socket
+\return true if socket is drained, false if not */
+NETWORK_API bool
+socket_drained(const socket_t* sock);
+
 NETWORK_API size_t
 socket_read(socket_t* sock, void* buffer, size_t size);
 
 NETWORK_API size_t
 socket_write(socket_t* sock, const void* buffer, size_t size);
 
+/*! Read from socket into a set of buffers in a single system call (scatter read).
+Buffers are filled in order, like a single #socket_read into their concatenation.
+\param sock Socket
+\param iov Buffer descriptors
+\param count Number of buffer descriptors
+\return Number of bytes read, 0 if no data available or socket closed */
+NETWORK_API size_t
+socket_readv(socket_t* sock, const network_iovec_t* iov, size_t count);
+
+/*! Write a set of buffers to socket (gather write), for example a protocol header and
+payload without copying them into a single buffer. Like #socket_write the call keeps
+writing until all data is written or the socket would block or fails, a short count
+is the partial progress and #network_iovec_advance skips the written data before
+writing the remainder.
+\param sock Socket
+\param iov Buffer descriptors
+\param count Number of buffer descriptors
+\return Number of bytes written */
+NETWORK_API size_t
+socket_writev(socket_t* sock, const network_iovec_t* iov, size_t count);
+
+/*! Enable or disable the output queue. With the queue enabled #socket_write and
+#socket_writev accept all data, sending what the socket takes and queueing the rest behind
+any already queued output. While the socket is in a poll the queue is flushed when the
+socket becomes writable, and the poll delivers NETWORKEVENT_OUTPUT_HIGH when the queue
+grows to the high watermark and NETWORKEVENT_OUTPUT_LOW when it then drains to the low
+watermark, with the number of queued bytes as result, letting the application stop and
+resume producing output. Sockets not in a poll are flushed with #socket_flush_output.
+Queued output is discarded when the socket is closed.
+\param sock Socket
+\param high High watermark in bytes, 0 to disable queueing new data (already queued
+             data is still flushed)
+\param low Low watermark in bytes, clamped to the high watermark */
+NETWORK_API void
+socket_set_output_queue(socket_t* sock, size_t high, size_t low);
+
+/*! Query number of bytes in the output queue
+\param sock Socket
+\return Number of queued bytes not yet sent */
+NETWORK_API size_t
+socket_output_queued(const socket_t* sock);
+
+/*! Send as much of the output queue as the socket accepts without blocking
+\param sock Socket
+\return Number of bytes still queued */
+NETWORK_API size_t
+socket_flush_output(socket_t* sock);
+
+/*! Send part of a file to socket. On Linux the data is transferred by the kernel
+with sendfile without copying it through user space, on other platforms and for file
+descriptors sendfile does not support the file is read in chunks and written with
+#socket_write. Like #socket_write the call keeps sending until all data is sent, the
+socket would block, the socket fails or the end of file is reached, and a short count
+is the partial progress. The file position of the descriptor is not modified.
+\param sock Socket
+\param fd File descriptor opened for reading
+\param offset Offset in file of first byte to send
+\param size Number of bytes to send
+\return Number of bytes sent */
+NETWORK_API size_t
+socket_send_file(socket_t* sock, int fd, size_t offset, size_t size);
+
+/*! Query total size of a set of buffers
+\param iov Buffer descriptors
+\param count Number of buffer descriptors
+\return Total size in bytes */
+NETWORK_API size_t
+network_iovec_size(const network_iovec_t* iov, size_t count);
+
+/*! Consume a number of bytes from the start of a set of buffers, adjusting the buffer
+descriptors in place after a partial vectored read or write
+\param iov Buffer descriptors
+\param count Number of buffer descriptors
+\param bytes Number of bytes to consume
+\return Index of first buffer with data remaining, count if all data was consumed */
+NETWORK_API size_t
+network_iovec_advance(network_iovec_t* iov, size_t count, size_t bytes);
+
 /*! Set beacon to fire when data is available on socket. For listening
 sockets the beacon is fired when a connection is available.
 \param sock Socket
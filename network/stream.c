@@ -22,29 +22,42 @@ _socket_stream_available_nonblock_read(const socket_stream_t* stream) {
 	return (stream->write_in - stream->read_in) + socket_available_read(stream->socket);
 }
 
-static void
-_socket_stream_doflush(socket_stream_t* stream) {
+//Flush buffered data followed by the given data in a single gather write, returns the
+//number of bytes of the given data written. Data not written remains buffered
+static size_t
+_socket_stream_doflush_gather(socket_stream_t* stream, const void* buffer, size_t size) {
 	socket_t* sock;
+	network_iovec_t iov[2];
 	size_t written;
 
-	if (!stream->write_out)
-		return;
-	
+	if (!stream->write_out && !size)
+		return 0;
+
 	sock = stream->socket;
 	if ((sock->fd == NETWORK_SOCKET_INVALID) ||
 	    (sock->state != SOCKETSTATE_CONNECTED))
-		return;
-
-	written = socket_write(sock, stream->buffer_out, stream->write_out);
+		return 0;
+
+	iov[0].base = stream->buffer_out;
+	iov[0].size = stream->write_out;
+	iov[1].base = (void*)buffer;
+	iov[1].size = size;
+	written = socket_writev(sock, iov, 2);
+	if (written >= stream->write_out) {
+		written -= stream->write_out;
+		stream->write_out = 0;
+		return written;
+	}
 	if (written) {
-		if (written < stream->write_out) {
-			memmove(stream->buffer_out, stream->buffer_out + written, stream->write_out - written);
-			stream->write_out -= written;
-		}
-		else {
-			stream->write_out = 0;
-		}
+		memmove(stream->buffer_out, stream->buffer_out + written, stream->write_out - written);
+		stream->write_out -= written;
 	}
+	return 0;
+}
+
+static void
+_socket_stream_doflush(socket_stream_t* stream) {
+	_socket_stream_doflush_gather(stream, nullptr, 0);
 }
 
 static size_t
@@ -105,11 +118,14 @@ _socket_stream_read(stream_t* stream, void* buffer, size_t size) {
 	while ((was_read < size) && try_again);
 
 	if (was_read < size) {
-		if (was_read)
-			log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
-			          STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): partial read %" PRIsize " of %" PRIsize " bytes"),
-			          (uintptr_t)sock, sock->fd, was_read, size);
-		socket_poll_state(sock);
+		//A drained non-blocking socket is an expected short read, see socket_drained
+		if (!socket_drained(sock)) {
+			if (was_read)
+				log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
+				          STRING_CONST("Socket stream (0x%" PRIfixPTR " : %d): partial read %" PRIsize " of %" PRIsize " bytes"),
+				          (uintptr_t)sock, sock->fd, was_read, size);
+			socket_poll_state(sock);
+		}
 	}
 
 exit:
@@ -123,6 +139,8 @@ _socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 	socket_t* sock;
 	size_t was_written = 0;
 	size_t remain;
+	size_t direct;
+	size_t buffered;
 
 	sockstream = (socket_stream_t*)stream;
 	sock = sockstream->socket;
@@ -145,16 +163,35 @@ _socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 			break;
 		}
 
-		if (remain) {
-			memcpy(sockstream->buffer_out + sockstream->write_out, buffer, remain);
-			buffer = pointer_offset_const(buffer, remain);
-
-			size -= remain;
-			was_written += remain;
-			sockstream->write_out += remain;
+		if (sockstream->reliable) {
+			//Data not fitting in the buffer is written together with the buffered data
+			buffered = sockstream->write_out;
+			direct = _socket_stream_doflush_gather(sockstream, buffer, size);
+			buffer = pointer_offset_const(buffer, direct);
+			size -= direct;
+			was_written += direct;
+			//Socket would block, keep what fits in the buffer
+			if (!direct && (sockstream->write_out == buffered) && (sock->state == SOCKETSTATE_CONNECTED)) {
+				remain = sockstream->buffer_out_size - sockstream->write_out;
+				memcpy(sockstream->buffer_out + sockstream->write_out, buffer, remain);
+				sockstream->write_out += remain;
+				was_written += remain;
+				break;
+			}
 		}
+		else {
+			//Datagrams are split at the buffer size to keep message boundaries
+			if (remain) {
+				memcpy(sockstream->buffer_out + sockstream->write_out, buffer, remain);
+				buffer = pointer_offset_const(buffer, remain);
+
+				size -= remain;
+				was_written += remain;
+				sockstream->write_out += remain;
+			}
 
-		_socket_stream_doflush(sockstream);
+			_socket_stream_doflush(sockstream);
+		}
 
 		if (sock->state != SOCKETSTATE_CONNECTED) {
 			log_warnf(HASH_NETWORK, WARNING_SUSPICIOUS,
@@ -164,7 +201,6 @@ _socket_stream_write(stream_t* stream, const void* buffer, size_t size) {
 		}
 
 		remain = sockstream->buffer_out_size - sockstream->write_out;
-
 	}
 	while (remain);
 
@@ -292,6 +328,17 @@ _socket_stream_last_modified(const stream_t* stream) {
 	return time_current();
 }
 
+size_t
+socket_stream_send_file(stream_t* stream, int fd, size_t offset, size_t size) {
+	socket_stream_t* sockstream = (socket_stream_t*)stream;
+	FOUNDATION_ASSERT(stream->type == STREAMTYPE_SOCKET);
+	//Buffered data precedes the file data
+	_socket_stream_doflush(sockstream);
+	if (sockstream->write_out)
+		return 0;
+	return socket_send_file(sockstream->socket, fd, offset, size);
+}
+
 stream_t*
 socket_stream_allocate(socket_t* sock, size_t buffer_in, size_t buffer_out) {
 	size_t size = sizeof(socket_stream_t) + buffer_in + buffer_out;
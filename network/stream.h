@@ -26,3 +26,14 @@ socket_stream_initialize(socket_stream_t* stream, socket_t* sock);
 
 NETWORK_API void
 socket_stream_finalize(socket_stream_t* stream);
+
+/*! Send part of a file through a socket stream with #socket_send_file, without copying
+the file data into the stream output buffer. Buffered output is flushed first, and if
+it cannot be flushed completely nothing is sent.
+\param stream Socket stream
+\param fd File descriptor opened for reading
+\param offset Offset in file of first byte to send
+\param size Number of bytes to send
+\return Number of bytes of the file sent */
+NETWORK_API size_t
+socket_stream_send_file(stream_t* stream, int fd, size_t offset, size_t size);
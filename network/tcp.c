@@ -19,6 +19,21 @@
 #if FOUNDATION_PLATFORM_POSIX
 #  include <netinet/tcp.h>
 #endif
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+#  include <errno.h>
+#  ifndef SO_ZEROCOPY
+#    define SO_ZEROCOPY 60
+#  endif
+#  ifndef MSG_ZEROCOPY
+#    define MSG_ZEROCOPY 0x4000000
+#  endif
+#  ifndef TCP_NOTSENT_LOWAT
+#    define TCP_NOTSENT_LOWAT 25
+#  endif
+#endif
+#if FOUNDATION_PLATFORM_WINDOWS
+#  include <mstcpip.h>
+#endif
 
 static void
 _tcp_socket_open(socket_t*, unsigned int);
@@ -28,8 +43,7 @@ _tcp_stream_initialize(socket_t*, stream_t*);
 
 socket_t*
 tcp_socket_allocate(void) {
-	socket_t* sock = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0,
-	                                 MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	socket_t* sock = _socket_allocate();
 	tcp_socket_initialize(sock);
 	return sock;
 }
@@ -50,14 +64,14 @@ tcp_socket_listen(socket_t* sock) {
 #endif
 	if ((sock->fd == NETWORK_SOCKET_INVALID) ||
 	    (sock->state != SOCKETSTATE_NOTCONNECTED) ||
-	    !sock->address_local) {
+	    !_socket_has_address_local(sock)) {
 		//Must be locally bound
 		return false;
 	}
 
 	if (listen(sock->fd, SOMAXCONN) != 0) {
 #if BUILD_ENABLE_LOG
-		string_t address = network_address_to_string(buffer, sizeof(buffer), sock->address_local, true);
+		string_t address = network_address_to_string(buffer, sizeof(buffer), socket_address_local(sock), true);
 		int sockerr = NETWORK_SOCKET_ERROR;
 		string_const_t errmsg = system_error_message(sockerr);
 		log_errorf(HASH_NETWORK, ERROR_SYSTEM_CALL_FAIL,
@@ -68,7 +82,7 @@ tcp_socket_listen(socket_t* sock) {
 	}
 
 #if BUILD_ENABLE_LOG
-	string_t address = network_address_to_string(buffer, sizeof(buffer), sock->address_local, true);
+	string_t address = network_address_to_string(buffer, sizeof(buffer), socket_address_local(sock), true);
 	log_infof(HASH_NETWORK,
 	          STRING_CONST("Listening on TCP/IP socket (0x%" PRIfixPTR " : %d) %.*s"),
 	          (uintptr_t)sock, sock->fd, STRING_FORMAT(address));
@@ -84,8 +98,8 @@ tcp_socket_listen(socket_t* sock) {
 socket_t*
 tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 	socket_t* accepted;
-	network_address_t* address_remote;
-	network_address_ip_t* address_ip;
+	network_address_storage_t address_remote;
+	network_address_ip_t* address_ip = &address_remote.ip;
 	socklen_t address_len;
 	int err = 0;
 	int fd;
@@ -96,7 +110,7 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 
 	if ((sock->state != SOCKETSTATE_LISTENING) ||
 	        (sock->fd == NETWORK_SOCKET_INVALID) ||
-	        !sock->address_local) { //Must be locally bound
+	        !_socket_has_address_local(sock)) { //Must be locally bound
 		log_errorf(HASH_NETWORK, ERROR_INVALID_VALUE,
 		           STRING_CONST("Unable to accept on a non-listening/unbound TCP/IP socket (%" PRIfixPTR
 		                        " : %d) state %d)"),
@@ -109,9 +123,8 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 	if ((timeoutms != NETWORK_TIMEOUT_INFINITE) && blocking)
 		socket_set_blocking(sock, false);
 
-	address_remote = network_address_clone(sock->address_local);
-	address_ip = (network_address_ip_t*)address_remote;
-	address_len = address_remote->address_size;
+	_socket_address_initialize(&address_remote, (int)sock->family);
+	address_len = address_remote.base.address_size;
 
 	fd = (int)accept(sock->fd, &address_ip->saddr, &address_len);
 	if (fd < 0) {
@@ -123,22 +136,11 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 			if (err == EAGAIN)
 #endif
 			{
-				struct timeval tval;
-				fd_set fdread, fderr;
-				int ret;
-
-				FD_ZERO(&fdread);
-				FD_ZERO(&fderr);
-				FD_SET(sock->fd, &fdread);
-				FD_SET(sock->fd, &fderr);
-
-				tval.tv_sec  = timeoutms / 1000;
-				tval.tv_usec = (timeoutms % 1000) * 1000;
-
-				ret = select(sock->fd + 1, &fdread, 0, &fderr, (timeoutms != NETWORK_TIMEOUT_INFINITE) ? &tval : nullptr);
-				if (ret > 0) {
-					address_len = address_remote->address_size;
+				if (_socket_poll_fd(sock->fd, NETWORK_POLLFD_READ, timeoutms) > 0) {
+					address_len = address_remote.base.address_size;
 					fd = (int)accept(sock->fd, &address_ip->saddr, &address_len);
+					if (fd < 0)
+						err = NETWORK_SOCKET_ERROR;
 				}
 			}
 		}
@@ -148,11 +150,18 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 		socket_set_blocking(sock, true);
 
 	if (fd < 0) {
+#if FOUNDATION_PLATFORM_WINDOWS
+		if (err == WSAEWOULDBLOCK)
+#else
+		if (err == EAGAIN)
+#endif
+			sock->flags |= SOCKETFLAG_DRAINED;
 		log_debugf(HASH_NETWORK, STRING_CONST("Accept returned invalid socket fd: %d"), fd);
-		memory_deallocate(address_remote);
 		return 0;
 	}
 
+	sock->flags &= ~SOCKETFLAG_DRAINED;
+
 	accepted = tcp_socket_allocate();
 	if (!accepted) {
 		log_debugf(HASH_NETWORK, STRING_CONST("Unable to allocate socket for accepted fd: %d"), fd);
@@ -163,26 +172,25 @@ tcp_socket_accept(socket_t* sock, unsigned int timeoutms) {
 	accepted->fd = fd;
 	accepted->state = SOCKETSTATE_CONNECTED;
 	accepted->family = address_ip->family;
-	accepted->address_remote = (network_address_t*)address_remote;
+	address_ip->address_size = (network_address_size_t)address_len;
+	_socket_set_address_remote(accepted, &address_remote.base);
 
-	_socket_store_address_local(accepted, (int)address_ip->family);
+	//Local address is only resolved if queried
+	_socket_defer_address_local(accepted);
 
 #if BUILD_ENABLE_LOG
 	{
 		char listenbuf[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
-		char localbuf[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
 		char remotebuf[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
 		string_t listenstr = network_address_to_string(listenbuf, sizeof(listenbuf),
-		                                               sock->address_local, true);
-		string_t localstr = network_address_to_string(localbuf, sizeof(localbuf),
-		                                              accepted->address_local, true);
+		                                               socket_address_local(sock), true);
 		string_t remotestr = network_address_to_string(remotebuf, sizeof(remotebuf),
-		                                               accepted->address_remote, true);
+		                                               socket_address_remote(accepted), true);
 		log_infof(HASH_NETWORK,
 		          STRING_CONST("Accepted connection on TCP/IP socket (0x%"
-		                       PRIfixPTR" : %d) %.*s: created socket (0x%" PRIfixPTR " : %d) %.*s with remote address %.*s"),
+		                       PRIfixPTR" : %d) %.*s: created socket (0x%" PRIfixPTR " : %d) with remote address %.*s"),
 		          (uintptr_t)sock, sock->fd, STRING_FORMAT(listenstr), (uintptr_t)accepted, accepted->fd,
-		          STRING_FORMAT(localstr), STRING_FORMAT(remotestr));
+		          STRING_FORMAT(remotestr));
 	}
 #endif
 
@@ -205,6 +213,201 @@ tcp_socket_set_delay(socket_t* sock, bool delay) {
 		setsockopt(sock->fd, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(int));
 }
 
+bool
+tcp_socket_cork(const socket_t* sock) {
+	return ((sock->flags & SOCKETFLAG_TCPCORK) != 0);
+}
+
+bool
+tcp_socket_set_cork(socket_t* sock, bool cork) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID || FOUNDATION_PLATFORM_APPLE
+	sock->flags = (cork ?
+	               sock->flags | SOCKETFLAG_TCPCORK :
+	               sock->flags & ~SOCKETFLAG_TCPCORK);
+#  if FOUNDATION_PLATFORM_APPLE
+	return _socket_set_option(sock, IPPROTO_TCP, TCP_NOPUSH, cork ? 1 : 0, STRING_CONST("cork"));
+#  else
+	return _socket_set_option(sock, IPPROTO_TCP, TCP_CORK, cork ? 1 : 0, STRING_CONST("cork"));
+#  endif
+#else
+	FOUNDATION_UNUSED(sock);
+	return !cork;
+#endif
+}
+
+bool
+tcp_socket_quickack(const socket_t* sock) {
+	return ((sock->flags & SOCKETFLAG_TCPQUICKACK) != 0);
+}
+
+bool
+tcp_socket_set_quickack(socket_t* sock, bool quickack) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	sock->flags = (quickack ?
+	               sock->flags | SOCKETFLAG_TCPQUICKACK :
+	               sock->flags & ~SOCKETFLAG_TCPQUICKACK);
+	return _socket_set_option(sock, IPPROTO_TCP, TCP_QUICKACK, quickack ? 1 : 0, STRING_CONST("quick ack"));
+#else
+	FOUNDATION_UNUSED(sock);
+	return !quickack;
+#endif
+}
+
+size_t
+tcp_socket_notsent_lowat(const socket_t* sock) {
+	return sock->notsent_lowat;
+}
+
+bool
+tcp_socket_set_notsent_lowat(socket_t* sock, size_t size) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID || FOUNDATION_PLATFORM_APPLE
+	//Kernel default is unlimited, restored by the largest value
+	int value = ((size > 0) && (size < 0x7FFFFFFF)) ? (int)size : 0x7FFFFFFF;
+	sock->notsent_lowat = (value < 0x7FFFFFFF) ? (unsigned int)value : 0;
+	return _socket_set_option(sock, IPPROTO_TCP, TCP_NOTSENT_LOWAT, value, STRING_CONST("not sent low watermark"));
+#else
+	FOUNDATION_UNUSED(sock);
+	return !size;
+#endif
+}
+
+bool
+tcp_socket_keepalive(const socket_t* sock, unsigned int* idle, unsigned int* interval, unsigned int* count) {
+	if (idle)
+		*idle = sock->keepalive_idle;
+	if (interval)
+		*interval = sock->keepalive_interval;
+	if (count)
+		*count = sock->keepalive_count;
+	return ((sock->flags & SOCKETFLAG_KEEPALIVE) != 0);
+}
+
+bool
+tcp_socket_set_keepalive(socket_t* sock, bool keepalive, unsigned int idle, unsigned int interval,
+                         unsigned int count) {
+	bool success = true;
+	sock->flags = (keepalive ?
+	               sock->flags | SOCKETFLAG_KEEPALIVE :
+	               sock->flags & ~SOCKETFLAG_KEEPALIVE);
+	sock->keepalive_idle = idle;
+	sock->keepalive_interval = interval;
+	sock->keepalive_count = count;
+	if (sock->fd == NETWORK_SOCKET_INVALID)
+		return true;
+#if FOUNDATION_PLATFORM_WINDOWS
+	{
+		//Probe count is fixed by the system
+		struct tcp_keepalive vals;
+		DWORD bytes = 0;
+		vals.onoff = keepalive ? 1 : 0;
+		vals.keepalivetime = (idle ? idle : 7200) * 1000;
+		vals.keepaliveinterval = (interval ? interval : 1) * 1000;
+		if (WSAIoctl((SOCKET)sock->fd, SIO_KEEPALIVE_VALS, &vals, sizeof(vals), nullptr, 0, &bytes,
+		             nullptr, nullptr) != 0) {
+			const int sockerr = NETWORK_SOCKET_ERROR;
+			const string_const_t errmsg = system_error_message(sockerr);
+			log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
+			          STRING_CONST("Unable to set keepalive option on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+			          (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+			success = false;
+		}
+	}
+#else
+	success = _socket_set_option(sock, SOL_SOCKET, SO_KEEPALIVE, keepalive ? 1 : 0, STRING_CONST("keepalive"));
+	if (keepalive && idle)
+#  if FOUNDATION_PLATFORM_APPLE
+		success = _socket_set_option(sock, IPPROTO_TCP, TCP_KEEPALIVE, (int)idle, STRING_CONST("keepalive idle")) && success;
+#  else
+		success = _socket_set_option(sock, IPPROTO_TCP, TCP_KEEPIDLE, (int)idle, STRING_CONST("keepalive idle")) && success;
+#  endif
+	if (keepalive && interval)
+		success = _socket_set_option(sock, IPPROTO_TCP, TCP_KEEPINTVL, (int)interval,
+		                             STRING_CONST("keepalive interval")) && success;
+	if (keepalive && count)
+		success = _socket_set_option(sock, IPPROTO_TCP, TCP_KEEPCNT, (int)count, STRING_CONST("keepalive count")) && success;
+#endif
+	return success;
+}
+
+bool
+tcp_socket_zerocopy(const socket_t* sock) {
+	return ((sock->flags & SOCKETFLAG_ZEROCOPY) != 0);
+}
+
+bool
+tcp_socket_set_zerocopy(socket_t* sock, bool zerocopy) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	sock->flags = (zerocopy ?
+	               sock->flags | SOCKETFLAG_ZEROCOPY :
+	               sock->flags & ~SOCKETFLAG_ZEROCOPY);
+	if (sock->fd != NETWORK_SOCKET_INVALID) {
+		int optval = zerocopy ? 1 : 0;
+		if ((setsockopt(sock->fd, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof(optval)) < 0) && zerocopy) {
+			const int sockerr = NETWORK_SOCKET_ERROR;
+			const string_const_t errmsg = system_error_message(sockerr);
+			log_warnf(HASH_NETWORK, WARNING_UNSUPPORTED,
+			          STRING_CONST("Unable to set zero-copy option on socket (0x%" PRIfixPTR " : %d): %.*s (%d)"),
+			          (uintptr_t)sock, sock->fd, STRING_FORMAT(errmsg), sockerr);
+			sock->flags &= ~SOCKETFLAG_ZEROCOPY;
+			return false;
+		}
+	}
+	return true;
+#else
+	FOUNDATION_UNUSED(sock);
+	return !zerocopy;
+#endif
+}
+
+size_t
+tcp_socket_write_zerocopy(socket_t* sock, const void* buffer, size_t size) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	socket_zerocopy_t pending;
+	size_t total_write = 0;
+
+	//Completions are only reported through a poll, and queued output must be sent first
+	if (!(sock->flags & SOCKETFLAG_ZEROCOPY) || !sock->poll || (sock->flags & SOCKETFLAG_OUTPUT_QUEUED))
+		return socket_write(sock, buffer, size);
+
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !size)
+		return 0;
+
+	while (total_write < size) {
+		long res = send(sock->fd, pointer_offset_const(buffer, total_write), size - total_write, MSG_ZEROCOPY);
+		if (res > 0) {
+			//Kernel numbers each successful zero-copy send call
+			total_write += (size_t)res;
+			++sock->zerocopy_next;
+		}
+		else {
+			_socket_write_failed(sock, total_write, size);
+			break;
+		}
+	}
+
+	sock->bytes_written += total_write;
+
+	if (total_write) {
+		pending.buffer = buffer;
+		pending.size = total_write;
+		pending.last = sock->zerocopy_next - 1;
+		array_push(sock->zerocopy, pending);
+		//Sends on a socket closed by the failure are never completed
+		if (sock->fd == NETWORK_SOCKET_INVALID)
+			_network_poll_zerocopy_cancel(sock->poll, sock, false);
+	}
+
+	return total_write;
+#else
+	return socket_write(sock, buffer, size);
+#endif
+}
+
+size_t
+tcp_socket_zerocopy_pending(const socket_t* sock) {
+	return array_size(sock->zerocopy);
+}
+
 static void
 _tcp_socket_open(socket_t* sock, unsigned int family) {
 	if (sock->fd != NETWORK_SOCKET_INVALID)
@@ -223,6 +426,17 @@ _tcp_socket_open(socket_t* sock, unsigned int family) {
 		log_debugf(HASH_NETWORK, STRING_CONST("Opened TCP/IP socket (0x%" PRIfixPTR " : %d)"),
 		           (uintptr_t)sock, sock->fd);
 		tcp_socket_set_delay(sock, sock->flags & SOCKETFLAG_TCPDELAY);
+		if (sock->flags & SOCKETFLAG_ZEROCOPY)
+			tcp_socket_set_zerocopy(sock, true);
+		if (sock->flags & SOCKETFLAG_TCPCORK)
+			tcp_socket_set_cork(sock, true);
+		if (sock->flags & SOCKETFLAG_TCPQUICKACK)
+			tcp_socket_set_quickack(sock, true);
+		if (sock->notsent_lowat)
+			tcp_socket_set_notsent_lowat(sock, sock->notsent_lowat);
+		if (sock->flags & SOCKETFLAG_KEEPALIVE)
+			tcp_socket_set_keepalive(sock, true, sock->keepalive_idle, sock->keepalive_interval,
+			                         sock->keepalive_count);
 	}
 }
 
@@ -36,3 +36,107 @@ tcp_socket_delay(socket_t* sock);
 
 NETWORK_API void
 tcp_socket_set_delay(socket_t* sock, bool delay);
+
+/*! Query if the socket is corked
+\param sock Socket
+\return true if corked, false if not */
+NETWORK_API bool
+tcp_socket_cork(const socket_t* sock);
+
+/*! Cork or uncork the socket (TCP_CORK, TCP_NOPUSH on macOS and iOS). While corked
+only full segments are sent, letting a response be assembled from several writes
+without sending partial segments. Uncorking sends any remaining data immediately.
+\param sock Socket
+\param cork Flag to cork the socket
+\return true if successful, false if error or not supported */
+NETWORK_API bool
+tcp_socket_set_cork(socket_t* sock, bool cork);
+
+/*! Query if quick acknowledgements are requested
+\param sock Socket
+\return true if requested, false if not */
+NETWORK_API bool
+tcp_socket_quickack(const socket_t* sock);
+
+/*! Request quick acknowledgements instead of delayed acknowledgements (TCP_QUICKACK,
+Linux only). The system may return to delayed acknowledgements on its own, set the
+option again after reads where latency matters.
+\param sock Socket
+\param quickack Flag to request quick acknowledgements
+\return true if successful, false if error or not supported */
+NETWORK_API bool
+tcp_socket_set_quickack(socket_t* sock, bool quickack);
+
+/*! Query limit of unsent data in the send buffer
+\param sock Socket
+\return Limit in bytes, 0 if not limited */
+NETWORK_API size_t
+tcp_socket_notsent_lowat(const socket_t* sock);
+
+/*! Limit the unsent data in the send buffer (TCP_NOTSENT_LOWAT, Linux, macOS and
+iOS). The socket is reported writable only while less unsent data is buffered, keeping
+data queued in the application where it can still be replaced or reprioritized and
+reducing memory held by the kernel.
+\param sock Socket
+\param size Limit in bytes, 0 for no limit
+\return true if successful, false if error or not supported */
+NETWORK_API bool
+tcp_socket_set_notsent_lowat(socket_t* sock, size_t size);
+
+/*! Query keepalive configuration
+\param sock Socket
+\param idle Receives idle time in seconds, 0 for system default. May be null
+\param interval Receives probe interval in seconds, 0 for system default. May be null
+\param count Receives number of probes, 0 for system default. May be null
+\return true if keepalive is enabled, false if not */
+NETWORK_API bool
+tcp_socket_keepalive(const socket_t* sock, unsigned int* idle, unsigned int* interval, unsigned int* count);
+
+/*! Enable or disable keepalive probes (SO_KEEPALIVE with TCP_KEEPIDLE, TCP_KEEPINTVL and
+TCP_KEEPCNT). On Windows the probe count is fixed by the system.
+\param sock Socket
+\param keepalive Flag to enable keepalive probes
+\param idle Idle time in seconds before the first probe, 0 for system default
+\param interval Time in seconds between probes, 0 for system default
+\param count Number of unanswered probes before the connection is dropped, 0 for
+             system default
+\return true if successful, false if error */
+NETWORK_API bool
+tcp_socket_set_keepalive(socket_t* sock, bool keepalive, unsigned int idle, unsigned int interval,
+                         unsigned int count);
+
+/*! Query if zero-copy sends are enabled
+\param sock Socket
+\return true if zero-copy sends are enabled, false if not */
+NETWORK_API bool
+tcp_socket_zerocopy(const socket_t* sock);
+
+/*! Enable or disable zero-copy sends with #tcp_socket_write_zerocopy (Linux only). Large
+sends then transmit directly from the caller buffer instead of copying it to the kernel,
+which is not worth the completion overhead for writes smaller than about 10KiB.
+\param sock Socket
+\param zerocopy Flag to enable zero-copy sends
+\return true if successful, false if not supported */
+NETWORK_API bool
+tcp_socket_set_zerocopy(socket_t* sock, bool zerocopy);
+
+/*! Write data without copying it to the kernel. If zero-copy sends are enabled and the
+socket is in a poll, the buffer must remain valid and unmodified until the poll returns a
+NETWORKEVENT_SEND_COMPLETE event for the socket with the buffer and number of bytes written
+by this call, and the event is to be used as the callback to release the buffer. Every call
+writing any data returns its buffer in exactly one such event. If the socket is closed
+before the kernel completes the send, the event has a negative result, and if the socket is
+removed from the poll or deallocated it also has a null socket. Otherwise the data is copied
+as with #socket_write and no completion event is generated.
+\param sock Socket
+\param buffer Data buffer
+\param size Number of bytes to write
+\return Number of bytes written */
+NETWORK_API size_t
+tcp_socket_write_zerocopy(socket_t* sock, const void* buffer, size_t size);
+
+/*! Query number of zero-copy writes pending completion
+\param sock Socket
+\return Number of writes with buffers still pinned by the kernel */
+NETWORK_API size_t
+tcp_socket_zerocopy_pending(const socket_t* sock);
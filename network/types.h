@@ -24,6 +24,7 @@
 #elif FOUNDATION_PLATFORM_POSIX
 #  include <sys/socket.h>
 #  include <netinet/in.h>
+#  include <poll.h>
 #endif
 
 #if defined( NETWORK_COMPILE ) && NETWORK_COMPILE
@@ -76,9 +77,49 @@ typedef enum {
 	NETWORKEVENT_CONNECTED,
 	NETWORKEVENT_DATAIN,
 	NETWORKEVENT_ERROR,
-	NETWORKEVENT_HANGUP
+	NETWORKEVENT_HANGUP,
+	NETWORKEVENT_DATAOUT,
+	NETWORKEVENT_READ_COMPLETE,
+	NETWORKEVENT_WRITE_COMPLETE,
+	NETWORKEVENT_TIMEOUT,
+	NETWORKEVENT_TIMER,
+	NETWORKEVENT_FD,
+	NETWORKEVENT_SEND_COMPLETE,
+	NETWORKEVENT_OUTPUT_HIGH,
+	NETWORKEVENT_OUTPUT_LOW,
+	NETWORKEVENT_COUNT
 } network_event_id;
 
+typedef enum {
+	NETWORK_DEADLINE_READ = 0,
+	NETWORK_DEADLINE_WRITE,
+	NETWORK_DEADLINE_IDLE,
+	NETWORK_DEADLINE_CONNECT,
+	NETWORK_DEADLINE_COUNT
+} network_deadline_t;
+
+typedef enum {
+	NETWORK_POLLFD_READ   = 0x01,
+	NETWORK_POLLFD_WRITE  = 0x02,
+	NETWORK_POLLFD_ERROR  = 0x04,
+	NETWORK_POLLFD_HANGUP = 0x08
+} network_poll_fd_flag_t;
+
+typedef enum {
+	NETWORK_POLL_BACKEND_DEFAULT = 0,
+	NETWORK_POLL_BACKEND_IO_URING,
+	NETWORK_POLL_BACKEND_EPOLL,
+	NETWORK_POLL_BACKEND_POLL,
+	NETWORK_POLL_BACKEND_SELECT
+} network_poll_backend_t;
+
+typedef enum {
+	NETWORK_POLL_PRIORITY_HIGH = 0,
+	NETWORK_POLL_PRIORITY_NORMAL,
+	NETWORK_POLL_PRIORITY_LOW,
+	NETWORK_POLL_PRIORITY_COUNT
+} network_poll_priority_t;
+
 #if FOUNDATION_PLATFORM_POSIX
 typedef socklen_t network_address_size_t;
 typedef size_t    network_send_size_t;
@@ -89,16 +130,33 @@ typedef int       network_send_size_t;
 
 typedef struct network_config_t      network_config_t;
 typedef struct network_address_t     network_address_t;
+typedef struct network_iovec_t       network_iovec_t;
 typedef struct network_poll_slot_t   network_poll_slot_t;
 typedef struct network_poll_event_t  network_poll_event_t;
+typedef struct network_poll_request_t network_poll_request_t;
+typedef struct network_poll_fd_t     network_poll_fd_t;
+typedef struct network_poll_statistics_t network_poll_statistics_t;
+typedef struct network_poll_histogram_t network_poll_histogram_t;
 typedef struct network_poll_t        network_poll_t;
+typedef struct network_poll_uring_t  network_poll_uring_t;
+typedef struct network_poll_timer_t  network_poll_timer_t;
+typedef struct network_poll_timers_t network_poll_timers_t;
+typedef struct network_poll_group_t  network_poll_group_t;
+typedef struct network_poll_shard_t  network_poll_shard_t;
+typedef struct network_handler_t     network_handler_t;
+typedef struct network_dispatch_t    network_dispatch_t;
 typedef struct socket_t              socket_t;
 typedef struct socket_stream_t       socket_stream_t;
 typedef struct socket_header_t       socket_header_t;
+typedef struct socket_zerocopy_t     socket_zerocopy_t;
 typedef union  socket_data_t         socket_data_t;
 
 typedef void (*socket_open_fn)(socket_t*, unsigned int);
 typedef void (*socket_stream_initialize_fn)(socket_t*, stream_t*);
+typedef void (*network_poll_group_fn)(network_poll_group_t*, network_poll_t*,
+                                      network_poll_event_t*, size_t);
+typedef void (*network_handler_fn)(network_dispatch_t*, const network_poll_event_t*, void*);
+typedef void (*network_poll_stall_fn)(network_poll_t*, uint64_t, void*);
 
 struct network_config_t {
 	size_t _unused;
@@ -130,9 +188,33 @@ typedef struct network_address_ipv6_t {
 	struct sockaddr_in6    saddr;
 } network_address_ipv6_t;
 
+//Storage for an address of any supported family, unset if address size is zero
+typedef union network_address_storage_t {
+	network_address_t      base;
+	network_address_ip_t   ip;
+	network_address_ipv4_t ipv4;
+	network_address_ipv6_t ipv6;
+} network_address_storage_t;
+
+//Scatter/gather buffer descriptor for vectored socket I/O
+struct network_iovec_t {
+	void* base;
+	size_t size;
+};
+
 struct network_poll_slot_t {
 	socket_t*  sock;
 	int        fd;
+	unsigned int mask;
+	unsigned int dirty;
+	unsigned int deadline[NETWORK_DEADLINE_COUNT];
+	unsigned int priority;
+	const network_handler_t* handler;
+	void* context;
+#if BUILD_ENABLE_NETWORK_IO_URING
+	unsigned int op;
+	unsigned int io;
+#endif
 };
 
 FOUNDATION_ALIGNED_STRUCT(socket_stream_t, 8) {
@@ -150,6 +232,14 @@ FOUNDATION_ALIGNED_STRUCT(socket_stream_t, 8) {
 	uint8_t* buffer_out;
 };
 
+//Caller buffer pinned by zero-copy sends until completed by the kernel
+struct socket_zerocopy_t {
+	const void* buffer;
+	size_t size;
+	//Kernel sequence number of the last send of the buffer
+	uint32_t last;
+};
+
 struct socket_header_t {
 	size_t id;
 	size_t size;
@@ -163,17 +253,17 @@ union socket_data_t {
 struct socket_t {
 	int fd;
 
-	uint32_t flags: 10;
+	uint32_t flags: 14;
 	uint32_t state: 6;
 	uint32_t type: 8;
-	uint32_t _unused: 8;
+	uint32_t _unused: 4;
 
 	uint32_t id;
 
 	network_address_family_t family;
 
-	network_address_t* address_local;
-	network_address_t* address_remote;
+	network_address_storage_t address_local;
+	network_address_storage_t address_remote;
 
 	size_t bytes_read;
 	size_t bytes_written;
@@ -181,44 +271,134 @@ struct socket_t {
 	socket_open_fn open_fn;
 	socket_stream_initialize_fn stream_initialize_fn;
 
+	network_poll_t* poll;
+	unsigned int poll_slot;
+	//Poll with queued add or remove requests for the socket not yet applied
+	network_poll_t* poll_queued;
+
 	beacon_t* beacon;
 	socket_data_t data;
 
+	//Zero-copy sends pending completion, and kernel sequence number of the next send
+	socket_zerocopy_t* zerocopy;
+	uint32_t zerocopy_next;
+
+	//Output queue of data not yet accepted by the kernel with its read offset, and
+	//watermarks in bytes, queue disabled if high watermark is zero
+	uint8_t* output;
+	size_t output_offset;
+	size_t output_high;
+	size_t output_low;
+
+	//Option values applied when the socket descriptor is created, zero for system default
+	unsigned int send_buffer;
+	unsigned int receive_buffer;
+	unsigned int tos;
+	unsigned int notsent_lowat;
+	unsigned int keepalive_idle;
+	unsigned int keepalive_interval;
+	unsigned int keepalive_count;
+
 #if FOUNDATION_PLATFORM_WINDOWS
 	void* event;
 #endif
 };
 
+#define NETWORK_POLL_HISTOGRAM_BUCKETS 32
+
+//Bucket 0 counts zero values, bucket n values in [2^(n-1), 2^n), the last bucket all larger values
+struct network_poll_histogram_t {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t bucket[NETWORK_POLL_HISTOGRAM_BUCKETS];
+};
+
+struct network_poll_statistics_t {
+	//Zero-timeout busy poll waits returning no events
+	uint64_t spins;
+	//Busy poll waits returning events
+	uint64_t spin_hits;
+	//Blocking waits
+	uint64_t sleeps;
+	//Gaps between polls exceeding the watchdog threshold
+	uint64_t stalls;
+	//Histograms collected with instrumentation enabled, times in microseconds.
+	//Time in backend wait system call
+	network_poll_histogram_t wait;
+	//Time translating backend results to events
+	network_poll_histogram_t process;
+	//Events per backend wait returning events or waiting
+	network_poll_histogram_t events;
+	//Time between return from and next call to network_poll
+	network_poll_histogram_t gap;
+	//Time in dispatcher handlers per iteration
+	network_poll_histogram_t dispatch;
+};
+
 #define NETWORK_DECLARE_POLL_BASE \
+	network_poll_backend_t backend; \
 	unsigned int timeout; \
+	unsigned int flags; \
+	unsigned int busy_poll; \
+	network_poll_statistics_t statistics; \
+	tick_t waited; \
+	tick_t returned; \
+	unsigned int watchdog; \
+	network_poll_stall_fn stall_fn; \
+	void* stall_context; \
 	size_t max_sockets; \
-	size_t num_sockets
+	size_t num_sockets; \
+	network_poll_slot_t* slots; \
+	network_poll_timers_t* timers; \
+	network_dispatch_t* dispatch; \
+	network_poll_event_t* pending; \
+	size_t pending_next; \
+	network_poll_event_t* sorted; \
+	size_t num_prioritized; \
+	network_poll_fd_t** fds; \
+	unsigned int* fd_table; \
+	beacon_t* beacon; \
+	mutex_t* queue_lock; \
+	network_poll_request_t* queue; \
+	atomic32_t queued; \
+	atomic32_t wakeup
 
 #if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
 #define NETWORK_DECLARE_POLL_PLATFORM \
 	NETWORK_DECLARE_POLL_BASE; \
 	int fd_poll; \
-	struct epoll_event* events
+	int fd_wakeup; \
+	network_poll_uring_t* uring; \
+	unsigned int* dirty; \
+	int* removed; \
+	struct epoll_event* events; \
+	struct pollfd* pollfds; \
+	struct pollfd* pollscratch
 #define NETWORK_DECLARE_POLL_DATA(size) \
-	network_poll_slot_t slots[size]; \
-	struct epoll_event eventarr[size]
+	network_poll_slot_t slotarr[size]; \
+	struct epoll_event eventarr[size + 1]; \
+	struct pollfd pollarr[size + 1]
 #elif FOUNDATION_PLATFORM_APPLE
 #define NETWORK_DECLARE_POLL_PLATFORM \
 	NETWORK_DECLARE_POLL_BASE; \
-	struct pollfd* pollfds
+	int fd_wakeup[2]; \
+	struct pollfd* pollfds; \
+	struct pollfd* pollscratch
 #define NETWORK_DECLARE_POLL_DATA(size) \
-	network_poll_slot_t slots[size]; \
-	struct pollfd pollarr[size]
+	network_poll_slot_t slotarr[size]; \
+	struct pollfd pollarr[size + 1]
 #else
 #define NETWORK_DECLARE_POLL_PLATFORM \
-	NETWORK_DECLARE_POLL_BASE
+	NETWORK_DECLARE_POLL_BASE; \
+	int fd_wakeup
 #define NETWORK_DECLARE_POLL_DATA(size) \
-	network_poll_slot_t slots[size]
+	network_poll_slot_t slotarr[size]
 #endif
 
 #define NETWORK_DECLARE_POLL \
 	NETWORK_DECLARE_POLL_PLATFORM; \
-	network_poll_slot_t slots[FOUNDATION_FLEXIBLE_ARRAY]
+	network_poll_slot_t slotarr[FOUNDATION_FLEXIBLE_ARRAY]
 
 #define NETWORK_DECLARE_FIXEDSIZE_POLL(size) \
 	NETWORK_DECLARE_POLL_PLATFORM; \
@@ -231,4 +411,84 @@ struct network_poll_t {
 struct network_poll_event_t {
 	network_event_id event;
 	socket_t* socket;
+	//Buffer and result (bytes transferred or negative error code) of completion events,
+	//deadline type of timeout events, user data and timer id of timer events,
+	//user data and ready flags (network_poll_fd_flag_t) of raw descriptor events
+	void* buffer;
+	int result;
+};
+
+struct network_poll_fd_t {
+	int fd;
+	unsigned int mask;
+	void* data;
+#if BUILD_ENABLE_NETWORK_IO_URING
+	unsigned int op;
+#endif
+};
+
+struct network_poll_request_t {
+	socket_t* sock;
+	int op;
+};
+
+#define NETWORK_POLL_TIMER_LEVELS 4
+#define NETWORK_POLL_TIMER_SLOTS  64
+
+struct network_poll_timer_t {
+	uint64_t deadline;
+	unsigned int interval;
+	unsigned int bucket;
+	unsigned int next;
+	unsigned int prev;
+	int type;
+	socket_t* sock;
+	void* data;
+};
+
+struct network_poll_timers_t {
+	tick_t base;
+	tick_t ticks_per_ms;
+	uint64_t now;
+	unsigned int count;
+	unsigned int free;
+	network_poll_timer_t* nodes;
+	uint64_t occupied[NETWORK_POLL_TIMER_LEVELS];
+	//Wheel buckets followed by the list of expired timers not yet delivered
+	unsigned int heads[NETWORK_POLL_TIMER_LEVELS * NETWORK_POLL_TIMER_SLOTS + 1];
+};
+
+struct network_poll_shard_t {
+	network_poll_group_t* group;
+	network_poll_t* poll;
+	mutex_t* lock;
+	atomic32_t load;
+	thread_t thread;
+};
+
+struct network_handler_t {
+	//Handler functions indexed by event id, null to ignore the event
+	network_handler_fn event[NETWORKEVENT_COUNT];
+};
+
+struct network_dispatch_t {
+	network_poll_t* poll;
+	const network_handler_t* handler;
+	void* context;
+	bool running;
+	size_t budget;
+	size_t class_budget[NETWORK_POLL_PRIORITY_COUNT];
+	network_poll_event_t* deferred;
+	size_t next;
+	size_t count;
+	network_poll_event_t events[FOUNDATION_FLEXIBLE_ARRAY];
+};
+
+struct network_poll_group_t {
+	network_poll_group_fn handler;
+	void* context;
+	unsigned int timeout;
+	atomic32_t running;
+	size_t num_shards;
+	network_poll_shard_t shards[FOUNDATION_FLEXIBLE_ARRAY];
 };
@@ -23,8 +23,7 @@ _udp_stream_initialize(socket_t*, stream_t*);
 
 socket_t*
 udp_socket_allocate(void) {
-	socket_t* sock = memory_allocate(HASH_NETWORK, sizeof(socket_t), 0,
-	                                 MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	socket_t* sock = _socket_allocate();
 	udp_socket_initialize(sock);
 	return sock;
 }
@@ -73,7 +72,7 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 	if (address)
 		*address = 0;
 
-	if ((sock->fd == NETWORK_SOCKET_INVALID) || !sock->address_local)
+	if ((sock->fd == NETWORK_SOCKET_INVALID) || !_socket_has_address_local(sock))
 		return 0;
 
 	if (sock->state != SOCKETSTATE_NOTCONNECTED) {
@@ -83,12 +82,11 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 		return 0;
 	}
 
-	if (!sock->address_remote || (sock->address_remote->family != sock->address_local->family)) {
-		if (sock->address_remote)
-			memory_deallocate(sock->address_remote);
-		sock->address_remote = network_address_clone(sock->address_local);
-	}
-	addr_ip = (network_address_ip_t*)sock->address_remote;
+	//Source address is received directly into the inline remote address
+	if ((!sock->address_remote.base.address_size || (sock->address_remote.base.family != sock->family)) &&
+	    !_socket_address_initialize(&sock->address_remote, (int)sock->family))
+		return 0;
+	addr_ip = &sock->address_remote.ip;
 
 	ret = recvfrom(sock->fd, (char*)buffer, (network_send_size_t)capacity, 0,
 	               &addr_ip->saddr, &addr_ip->address_size);
@@ -100,7 +98,7 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 #if BUILD_ENABLE_NETWORK_DUMP_TRAFFIC > 0
 		{
 			char addr_buffer[NETWORK_ADDRESS_NUMERIC_MAX_LENGTH];
-			string_t address_str = network_address_to_string(addr_buffer, sizeof(addr_buffer), sock->address_remote, true);
+			string_t address_str = network_address_to_string(addr_buffer, sizeof(addr_buffer), &sock->address_remote.base, true);
 			log_debugf(HASH_NETWORK, STRING_CONST("Socket (0x%" PRIfixPTR
 			                                      " : %d) read %d of %" PRIsize " bytes from %.*s"),
 			           (uintptr_t)sock, sock->fd, (int)ret, capacity, STRING_FORMAT(address_str));
@@ -123,7 +121,9 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 #endif
 
 		if (address)
-			*address = sock->address_remote;
+			*address = &sock->address_remote.base;
+
+		sock->flags &= ~SOCKETFLAG_DRAINED;
 
 		return (size_t)ret;
 	}
@@ -131,21 +131,23 @@ udp_socket_recvfrom(socket_t* sock, void* buffer, size_t capacity, network_addre
 	int sockerr = NETWORK_SOCKET_ERROR;
 
 #if FOUNDATION_PLATFORM_WINDOWS
-	int serr = 0;
-	int slen = sizeof(int);
-	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
+	if (sockerr == WSAEWOULDBLOCK)
 #else
-	int serr = 0;
-	socklen_t slen = sizeof(int);
-	getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
+	if (sockerr == EAGAIN)
 #endif
-
+	{
+		sock->flags |= SOCKETFLAG_DRAINED;
+	}
+	else {
 #if FOUNDATION_PLATFORM_WINDOWS
-	if (sockerr != WSAEWOULDBLOCK)
+		int serr = 0;
+		int slen = sizeof(int);
+		getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (char*)&serr, &slen);
 #else
-	if (sockerr != EAGAIN)
+		int serr = 0;
+		socklen_t slen = sizeof(int);
+		getsockopt(sock->fd, SOL_SOCKET, SO_ERROR, (void*)&serr, &slen);
 #endif
-	{
 		string_const_t errmsg = system_error_message(sockerr);
 		log_warnf(HASH_NETWORK, WARNING_SYSTEM_CALL_FAIL,
 		          STRING_CONST("Socket recvfrom() failed on UDP socket (0x%" PRIfixPTR
@@ -218,8 +220,9 @@ udp_socket_sendto(socket_t* sock, const void* buffer, size_t size,
 		}
 #endif
 
-		if (!sock->address_local)
-			_socket_store_address_local(sock, (int)address->family);
+		//First send binds the socket implicitly
+		if (!_socket_has_address_local(sock))
+			_socket_defer_address_local(sock);
 
 		return (size_t)ret;
 	}
@@ -131,6 +131,92 @@ DECLARE_TEST(tcp, bind) {
 	return 0;
 }
 
+#define TEST_SOCKET_RECYCLE_COUNT 1500
+
+static void*
+recycle_thread(void* arg) {
+	socket_t** sockets = arg;
+	size_t isock;
+	for (isock = 0; isock < TEST_SOCKET_RECYCLE_COUNT; ++isock)
+		sockets[isock] = (isock % 2) ? tcp_socket_allocate() : udp_socket_allocate();
+	return 0;
+}
+
+static void*
+recycle_exit_thread(void* arg) {
+	socket_t** sock = arg;
+	*sock = tcp_socket_allocate();
+	socket_deallocate(*sock);
+	network_thread_finalize();
+	return 0;
+}
+
+static void*
+recycle_allocate_thread(void* arg) {
+	socket_t** sock = arg;
+	*sock = udp_socket_allocate();
+	return 0;
+}
+
+DECLARE_TEST(tcp, recycle) {
+	socket_t* sockets[TEST_SOCKET_RECYCLE_COUNT];
+	socket_t* sock;
+	socket_t* recycled;
+	thread_t thread;
+	size_t isock;
+
+	//Deallocated sockets are recycled by the next allocation on the same thread
+	sock = tcp_socket_allocate();
+	socket_deallocate(sock);
+	recycled = udp_socket_allocate();
+	EXPECT_EQ(recycled, sock);
+	EXPECT_EQ(socket_type(recycled), NETWORK_SOCKETTYPE_UDP);
+	EXPECT_EQ(socket_address_local(recycled), 0);
+	socket_deallocate(recycled);
+
+	//Sockets allocated on one thread and deallocated on another, spilling over
+	//the thread cache into the shared pool
+	thread_initialize(&thread, recycle_thread, sockets, STRING_CONST("recycle"), THREAD_PRIORITY_NORMAL, 0);
+	EXPECT_TRUE(thread_start(&thread));
+	thread_join(&thread);
+	thread_finalize(&thread);
+	for (isock = 0; isock < TEST_SOCKET_RECYCLE_COUNT; ++isock) {
+		EXPECT_NE(sockets[isock], 0);
+		EXPECT_EQ(socket_state(sockets[isock]), SOCKETSTATE_NOTCONNECTED);
+		if (isock)
+			EXPECT_NE(sockets[isock], sockets[isock - 1]);
+	}
+	for (isock = 0; isock < TEST_SOCKET_RECYCLE_COUNT; ++isock)
+		socket_deallocate(sockets[isock]);
+
+	if (network_supports_ipv4()) {
+		network_address_ipv4_t address;
+		network_address_ipv4_initialize(&address);
+		for (isock = 0; isock < 100; ++isock) {
+			sockets[isock] = tcp_socket_allocate();
+			EXPECT_TRUE(socket_bind(sockets[isock], (network_address_t*)&address));
+			EXPECT_NE(socket_address_local(sockets[isock]), 0);
+		}
+		for (isock = 0; isock < 100; ++isock)
+			socket_deallocate(sockets[isock]);
+	}
+
+	//Sockets cached by an exiting thread are returned to the shared pool and reused
+	//by the next thread refilling its cache
+	thread_initialize(&thread, recycle_exit_thread, &sock, STRING_CONST("recycle"), THREAD_PRIORITY_NORMAL, 0);
+	EXPECT_TRUE(thread_start(&thread));
+	thread_join(&thread);
+	thread_finalize(&thread);
+	thread_initialize(&thread, recycle_allocate_thread, &recycled, STRING_CONST("recycle"), THREAD_PRIORITY_NORMAL, 0);
+	EXPECT_TRUE(thread_start(&thread));
+	thread_join(&thread);
+	thread_finalize(&thread);
+	EXPECT_EQ(recycled, sock);
+	socket_deallocate(recycled);
+
+	return 0;
+}
+
 DECLARE_TEST(udp, create) {
 	socket_t* sock = udp_socket_allocate();
 	socket_deallocate(sock);
@@ -216,6 +302,7 @@ test_socket_declare(void) {
 	ADD_TEST(tcp, create);
 	ADD_TEST(tcp, blocking);
 	ADD_TEST(tcp, bind);
+	ADD_TEST(tcp, recycle);
 
 	ADD_TEST(udp, create);
 	ADD_TEST(udp, blocking);
@@ -14,6 +14,11 @@
 #include <foundation/foundation.h>
 #include <test/test.h>
 
+#if FOUNDATION_PLATFORM_POSIX
+#  include <stdlib.h>
+#  include <unistd.h>
+#endif
+
 static application_t
 test_tcp_application(void) {
 	application_t app;
@@ -368,6 +373,44 @@ DECLARE_TEST(tcp, connect_ipv6) {
 	return 0;
 }
 
+DECLARE_TEST(tcp, connect_refused) {
+	network_address_ipv4_t address;
+	unsigned int port;
+	socket_t* sock;
+	tick_t start;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	//Port of a closed socket has no listener
+	sock = tcp_socket_allocate();
+	network_address_ipv4_initialize(&address);
+	EXPECT_TRUE(socket_bind(sock, (network_address_t*)&address));
+	port = network_address_ip_port(socket_address_local(sock));
+	socket_deallocate(sock);
+
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	network_address_ip_set_port((network_address_t*)&address, port);
+
+	//Refused connection with timeout
+	sock = tcp_socket_allocate();
+	EXPECT_FALSE(socket_connect(sock, (network_address_t*)&address, 1000));
+	EXPECT_EQ(socket_state(sock), SOCKETSTATE_NOTCONNECTED);
+	socket_deallocate(sock);
+
+	//Refused connection in progress is detected when polling state
+	sock = tcp_socket_allocate();
+	socket_set_blocking(sock, false);
+	socket_connect(sock, (network_address_t*)&address, 0);
+	start = time_current();
+	while ((socket_poll_state(sock) == SOCKETSTATE_CONNECTING) && (time_elapsed(start) < REAL_C(2.0)))
+		thread_sleep(10);
+	EXPECT_EQ(socket_poll_state(sock), SOCKETSTATE_NOTCONNECTED);
+	socket_deallocate(sock);
+
+	return 0;
+}
+
 DECLARE_TEST(tcp, io_ipv4) {
 	network_address_t* address_bind = 0;
 	network_address_t** address_local = 0;
@@ -420,6 +463,14 @@ DECLARE_TEST(tcp, io_ipv4) {
 	EXPECT_INTEQ(client_state, SOCKETSTATE_CONNECTED);
 	EXPECT_INTEQ(server_state, SOCKETSTATE_CONNECTED);
 
+	//Local addresses are resolved on demand and match the remote end
+	EXPECT_NE(socket_address_local(sock_server), 0);
+	EXPECT_NE(socket_address_local(sock_client), 0);
+	EXPECT_TRUE(network_address_equal(socket_address_local(sock_server), socket_address_remote(sock_client)));
+	EXPECT_TRUE(network_address_equal(socket_address_local(sock_client), socket_address_remote(sock_server)));
+	EXPECT_INTEQ(network_address_ip_port(socket_address_local(sock_server)),
+	             network_address_ip_port(socket_address_local(sock_listen)));
+
 	socket_deallocate(sock_listen);
 
 	socket_set_blocking(sock_client, true);
@@ -679,14 +730,1396 @@ DECLARE_TEST(tcp, stream_ipv6) {
 	return 0;
 }
 
+static bool
+tcp_connected_pair_ipv4(socket_t** sock_server, socket_t** sock_client) {
+	network_address_t** address_local = 0;
+	network_address_t* address_connect = 0;
+	network_address_ipv4_t any;
+	unsigned int iaddr, asize;
+
+	socket_t* sock_listen = tcp_socket_allocate();
+
+	*sock_server = 0;
+	*sock_client = tcp_socket_allocate();
+
+	network_address_ipv4_initialize(&any);
+	socket_bind(sock_listen, (network_address_t*)&any);
+	tcp_socket_listen(sock_listen);
+
+	address_local = network_address_local();
+	for (iaddr = 0, asize = array_size(address_local); iaddr < asize; ++iaddr) {
+		if (network_address_family(address_local[iaddr]) == NETWORK_ADDRESSFAMILY_IPV4) {
+			address_connect = address_local[iaddr];
+			break;
+		}
+	}
+	if (address_connect) {
+		network_address_ip_set_port(address_connect,
+		                            network_address_ip_port(socket_address_local(sock_listen)));
+		socket_set_blocking(*sock_client, false);
+		socket_connect(*sock_client, address_connect, 0);
+		thread_sleep(100);
+		*sock_server = tcp_socket_accept(sock_listen, 0);
+	}
+
+	network_address_array_deallocate(address_local);
+	socket_deallocate(sock_listen);
+
+	if (!*sock_server || (socket_poll_state(*sock_client) != SOCKETSTATE_CONNECTED)) {
+		socket_deallocate(*sock_server);
+		socket_deallocate(*sock_client);
+		*sock_server = *sock_client = 0;
+		return false;
+	}
+
+	socket_set_blocking(*sock_server, false);
+	return true;
+}
+
+DECLARE_TEST(tcp, poll_edge_triggered) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	network_address_ipv4_t any;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	char buffer[64] = {0};
+
+	socket_t* sock_listen = 0;
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+
+	poll = network_poll_allocate(4);
+	EXPECT_FALSE(network_poll_edge_triggered(poll));
+	network_poll_set_edge_triggered(poll, true);
+	EXPECT_TRUE(network_poll_edge_triggered(poll));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_server);
+
+	//Partially read socket is not reported again until new data arrives
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer) / 4), sizeof(buffer) / 4);
+	EXPECT_FALSE(socket_drained(sock_server));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100), 0);
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), sizeof(buffer) - (sizeof(buffer) / 4));
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), 0);
+	EXPECT_TRUE(socket_drained(sock_server));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100), 0);
+
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_server);
+	EXPECT_FALSE(socket_drained(sock_server));
+
+	//Accepting with no connection pending drains a listening socket
+	sock_listen = tcp_socket_allocate();
+	network_address_ipv4_initialize(&any);
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&any));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+	EXPECT_FALSE(socket_drained(sock_listen));
+	EXPECT_EQ(tcp_socket_accept(sock_listen, 0), 0);
+	EXPECT_TRUE(socket_drained(sock_listen));
+
+	network_poll_deallocate(poll);
+
+	socket_deallocate(sock_listen);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+#endif
+	return 0;
+}
+
+DECLARE_TEST(tcp, io_vectored) {
+	char header[8];
+	char payload[1000];
+	char header_in[8] = {0};
+	char payload_in[1000] = {0};
+	network_iovec_t iov[3];
+	size_t ivec, total, read;
+	tick_t start;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+
+	memset(header, 0x11, sizeof(header));
+	for (ivec = 0; ivec < sizeof(payload); ++ivec)
+		payload[ivec] = (char)ivec;
+
+	//Header and payload in a single write, empty vectors are skipped
+	iov[0].base = header;
+	iov[0].size = sizeof(header);
+	iov[1].base = nullptr;
+	iov[1].size = 0;
+	iov[2].base = payload;
+	iov[2].size = sizeof(payload);
+	EXPECT_SIZEEQ(network_iovec_size(iov, 3), sizeof(header) + sizeof(payload));
+	EXPECT_SIZEEQ(socket_writev(sock_client, iov, 3), sizeof(header) + sizeof(payload));
+
+	//Scatter into separate header and payload buffers, advancing on partial reads
+	iov[0].base = header_in;
+	iov[0].size = sizeof(header_in);
+	iov[1].base = payload_in;
+	iov[1].size = sizeof(payload_in);
+	ivec = 0;
+	total = 0;
+	start = time_current();
+	while ((ivec < 2) && (time_elapsed(start) < REAL_C(2.0))) {
+		read = socket_readv(sock_server, iov + ivec, 2 - ivec);
+		total += read;
+		ivec += network_iovec_advance(iov + ivec, 2 - ivec, read);
+		if (!read)
+			thread_sleep(10);
+	}
+	EXPECT_SIZEEQ(total, sizeof(header) + sizeof(payload));
+	EXPECT_EQ(memcmp(header, header_in, sizeof(header)), 0);
+	EXPECT_EQ(memcmp(payload, payload_in, sizeof(payload)), 0);
+	EXPECT_EQ(iov[1].base, payload_in + sizeof(payload_in));
+	EXPECT_SIZEEQ(iov[1].size, 0);
+
+	//Advancing within a buffer adjusts it in place
+	iov[0].base = header;
+	iov[0].size = sizeof(header);
+	iov[1].base = payload;
+	iov[1].size = sizeof(payload);
+	EXPECT_SIZEEQ(network_iovec_advance(iov, 2, sizeof(header) + 10), 1);
+	EXPECT_EQ(iov[1].base, payload + 10);
+	EXPECT_SIZEEQ(iov[1].size, sizeof(payload) - 10);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, io_zerocopy) {
+	size_t num_events, ievt, total, read;
+	size_t size = 32 * 1024;
+	bool got_complete;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	tick_t start;
+	char* buffer;
+	char* buffer_in;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+
+	poll = network_poll_allocate(2);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+
+	//Not supported on all platforms and kernels
+	if (!tcp_socket_set_zerocopy(sock_client, true)) {
+		EXPECT_FALSE(tcp_socket_zerocopy(sock_client));
+		network_poll_deallocate(poll);
+		socket_deallocate(sock_server);
+		socket_deallocate(sock_client);
+		return 0;
+	}
+	EXPECT_TRUE(tcp_socket_zerocopy(sock_client));
+
+	buffer = memory_allocate(0, size, 0, MEMORY_PERSISTENT);
+	buffer_in = memory_allocate(0, size, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (total = 0; total < size; ++total)
+		buffer[total] = (char)(total * 7);
+
+	EXPECT_SIZEEQ(tcp_socket_write_zerocopy(sock_client, buffer, size), size);
+	EXPECT_SIZEEQ(tcp_socket_zerocopy_pending(sock_client), 1);
+
+	//Buffer is released by a completion event once the kernel is done with it
+	got_complete = false;
+	total = 0;
+	start = time_current();
+	while ((!got_complete || (total < size)) && (time_elapsed(start) < REAL_C(5.0))) {
+		read = socket_read(sock_server, buffer_in + total, size - total);
+		total += read;
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			EXPECT_NE(events[ievt].event, NETWORKEVENT_ERROR);
+			if (events[ievt].event == NETWORKEVENT_SEND_COMPLETE) {
+				EXPECT_EQ(events[ievt].socket, sock_client);
+				EXPECT_EQ(events[ievt].buffer, buffer);
+				EXPECT_INTEQ(events[ievt].result, (int)size);
+				got_complete = true;
+			}
+		}
+	}
+	EXPECT_TRUE(got_complete);
+	EXPECT_SIZEEQ(total, size);
+	EXPECT_SIZEEQ(tcp_socket_zerocopy_pending(sock_client), 0);
+	EXPECT_EQ(memcmp(buffer, buffer_in, size), 0);
+	EXPECT_EQ(socket_state(sock_client), SOCKETSTATE_CONNECTED);
+
+	//Without a poll to report completions data is copied
+	network_poll_remove_socket(poll, sock_client);
+	EXPECT_SIZEEQ(tcp_socket_write_zerocopy(sock_client, buffer, 64), 64);
+	EXPECT_SIZEEQ(tcp_socket_zerocopy_pending(sock_client), 0);
+
+	//Buffer of a send not completed when the socket closes is returned with a failed result
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	EXPECT_SIZEEQ(tcp_socket_write_zerocopy(sock_client, buffer, size), size);
+	EXPECT_SIZEEQ(tcp_socket_zerocopy_pending(sock_client), 1);
+	socket_close(sock_client);
+	EXPECT_SIZEEQ(tcp_socket_zerocopy_pending(sock_client), 0);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_SEND_COMPLETE);
+	EXPECT_EQ(events[0].socket, sock_client);
+	EXPECT_EQ(events[0].buffer, buffer);
+	EXPECT_INTEQ(events[0].result, -1);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	//Socket deallocated with a send pending returns the buffer without the socket
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	EXPECT_TRUE(tcp_socket_set_zerocopy(sock_client, true));
+	EXPECT_SIZEEQ(tcp_socket_write_zerocopy(sock_client, buffer, size), size);
+	socket_deallocate(sock_client);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_SEND_COMPLETE);
+	EXPECT_EQ(events[0].socket, 0);
+	EXPECT_EQ(events[0].buffer, buffer);
+	EXPECT_INTEQ(events[0].result, -1);
+
+	memory_deallocate(buffer);
+	memory_deallocate(buffer_in);
+	network_poll_deallocate(poll);
+	socket_deallocate(sock_server);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, io_queue) {
+	size_t num_events, ievt, total, written, read, ibyte;
+	size_t chunk = 16 * 1024;
+	size_t high = 256 * 1024;
+	size_t low = 32 * 1024;
+	bool got_high, got_low;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	tick_t start;
+	unsigned char* buffer;
+	unsigned char* buffer_in;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+
+	poll = network_poll_allocate(2);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	socket_set_output_queue(sock_client, high, low);
+
+	buffer = memory_allocate(0, chunk, 0, MEMORY_PERSISTENT);
+	buffer_in = memory_allocate(0, chunk, 0, MEMORY_PERSISTENT);
+
+	//All data is accepted, the part the socket does not take is queued
+	written = 0;
+	while ((socket_output_queued(sock_client) < high) && (written < 64 * 1024 * 1024)) {
+		for (ibyte = 0; ibyte < chunk; ++ibyte)
+			buffer[ibyte] = (unsigned char)((written + ibyte) * 7);
+		EXPECT_SIZEEQ(socket_write(sock_client, buffer, chunk), chunk);
+		written += chunk;
+	}
+	EXPECT_SIZEGE(socket_output_queued(sock_client), high);
+
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0);
+	got_high = false;
+	for (ievt = 0; ievt < num_events; ++ievt) {
+		if (events[ievt].event == NETWORKEVENT_OUTPUT_HIGH) {
+			EXPECT_EQ(events[ievt].socket, sock_client);
+			EXPECT_SIZEGE((size_t)events[ievt].result, high);
+			got_high = true;
+		}
+	}
+	EXPECT_TRUE(got_high);
+
+	//Queue is flushed by the poll as the receiver drains the connection, in order
+	got_low = false;
+	total = 0;
+	start = time_current();
+	while ((total < written) && (time_elapsed(start) < REAL_C(10.0))) {
+		read = socket_read(sock_server, buffer_in, chunk);
+		for (ibyte = 0; ibyte < read; ++ibyte) {
+			if (buffer_in[ibyte] != (unsigned char)((total + ibyte) * 7))
+				break;
+		}
+		EXPECT_SIZEEQ(ibyte, read);
+		total += read;
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), read ? 0 : 10);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			EXPECT_NE(events[ievt].event, NETWORKEVENT_ERROR);
+			EXPECT_NE(events[ievt].event, NETWORKEVENT_DATAOUT);
+			if (events[ievt].event == NETWORKEVENT_OUTPUT_LOW) {
+				EXPECT_SIZEGE(low, (size_t)events[ievt].result);
+				got_low = true;
+			}
+		}
+	}
+	EXPECT_TRUE(got_low);
+	EXPECT_SIZEEQ(total, written);
+	EXPECT_SIZEEQ(socket_output_queued(sock_client), 0);
+	EXPECT_SIZEEQ(socket_flush_output(sock_client), 0);
+	EXPECT_FALSE(network_poll_write_interest(poll, sock_client));
+
+	memory_deallocate(buffer);
+	memory_deallocate(buffer_in);
+	network_poll_deallocate(poll);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, io_sendfile) {
+#if FOUNDATION_PLATFORM_POSIX
+	char path[] = "/tmp/network_sendfile_XXXXXX";
+	size_t size = 100 * 1024;
+	size_t offset = 1000;
+	size_t length = 60 * 1024;
+	size_t total, sent, read, ibyte;
+	stream_t* stream;
+	tick_t start;
+	char* data;
+	char* data_in;
+	int fd;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	fd = mkstemp(path);
+	EXPECT_NE(fd, -1);
+	data = memory_allocate(0, size, 0, MEMORY_PERSISTENT);
+	data_in = memory_allocate(0, size, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (ibyte = 0; ibyte < size; ++ibyte)
+		data[ibyte] = (char)(ibyte * 13);
+	EXPECT_EQ(write(fd, data, size), (ssize_t)size);
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+
+	//Range of the file with partial progress on a non-blocking socket
+	total = 0;
+	sent = 0;
+	start = time_current();
+	while ((total < length) && (time_elapsed(start) < REAL_C(5.0))) {
+		if (sent < length)
+			sent += socket_send_file(sock_client, fd, offset + sent, length - sent);
+		read = socket_read(sock_server, data_in + total, length - total);
+		total += read;
+		if (!read)
+			thread_sleep(1);
+	}
+	EXPECT_SIZEEQ(sent, length);
+	EXPECT_SIZEEQ(total, length);
+	EXPECT_EQ(memcmp(data + offset, data_in, length), 0);
+
+	//Sending stops at end of file
+	EXPECT_SIZEEQ(socket_send_file(sock_client, fd, size - 10, 100), 10);
+	EXPECT_SIZEEQ(socket_send_file(sock_client, fd, size, 100), 0);
+	total = 0;
+	start = time_current();
+	while ((total < 10) && (time_elapsed(start) < REAL_C(2.0)))
+		total += socket_read(sock_server, data_in + total, 10 - total);
+	EXPECT_SIZEEQ(total, 10);
+	EXPECT_EQ(memcmp(data + size - 10, data_in, 10), 0);
+
+	//Stream output buffered before the file is sent first
+	stream = socket_stream_allocate(sock_client, 64, 64);
+	stream_write(stream, "head", 4);
+	EXPECT_SIZEEQ(socket_stream_send_file(stream, fd, 0, 256), 256);
+	total = 0;
+	start = time_current();
+	while ((total < 260) && (time_elapsed(start) < REAL_C(2.0)))
+		total += socket_read(sock_server, data_in + total, 260 - total);
+	EXPECT_SIZEEQ(total, 260);
+	EXPECT_EQ(memcmp(data_in, "head", 4), 0);
+	EXPECT_EQ(memcmp(data, data_in + 4, 256), 0);
+	stream_deallocate(stream);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	close(fd);
+	unlink(path);
+	memory_deallocate(data);
+	memory_deallocate(data_in);
+#endif
+	return 0;
+}
+
+DECLARE_TEST(tcp, options) {
+	network_address_ipv4_t address;
+	unsigned int idle, interval, count;
+	socket_t* sock;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	//Options set before the descriptor exists are applied when it is created
+	sock = tcp_socket_allocate();
+	EXPECT_INTEQ(socket_fd(sock), NETWORK_SOCKET_INVALID);
+	EXPECT_TRUE(socket_set_send_buffer_size(sock, 64 * 1024));
+	EXPECT_TRUE(socket_set_receive_buffer_size(sock, 128 * 1024));
+	EXPECT_TRUE(socket_set_tos(sock, 46 << 2));
+	EXPECT_TRUE(tcp_socket_set_keepalive(sock, true, 30, 5, 3));
+	EXPECT_SIZEEQ(socket_send_buffer_size(sock), 64 * 1024);
+	EXPECT_SIZEEQ(socket_receive_buffer_size(sock), 128 * 1024);
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	EXPECT_TRUE(tcp_socket_set_cork(sock, true));
+	EXPECT_TRUE(tcp_socket_set_quickack(sock, true));
+	EXPECT_TRUE(tcp_socket_set_notsent_lowat(sock, 16 * 1024));
+#endif
+
+	network_address_ipv4_initialize(&address);
+	EXPECT_TRUE(socket_bind(sock, (network_address_t*)&address));
+	EXPECT_NE(socket_fd(sock), NETWORK_SOCKET_INVALID);
+
+	EXPECT_SIZEGE(socket_send_buffer_size(sock), 64 * 1024);
+	EXPECT_SIZEGE(socket_receive_buffer_size(sock), 128 * 1024);
+	EXPECT_INTEQ(socket_tos(sock), 46 << 2);
+	EXPECT_TRUE(tcp_socket_keepalive(sock, &idle, &interval, &count));
+	EXPECT_INTEQ(idle, 30);
+	EXPECT_INTEQ(interval, 5);
+	EXPECT_INTEQ(count, 3);
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	EXPECT_TRUE(tcp_socket_cork(sock));
+	EXPECT_TRUE(tcp_socket_quickack(sock));
+	EXPECT_SIZEEQ(tcp_socket_notsent_lowat(sock), 16 * 1024);
+
+	//Options are changed on the open descriptor
+	EXPECT_TRUE(tcp_socket_set_cork(sock, false));
+	EXPECT_FALSE(tcp_socket_cork(sock));
+	EXPECT_TRUE(tcp_socket_set_notsent_lowat(sock, 0));
+	EXPECT_SIZEEQ(tcp_socket_notsent_lowat(sock), 0);
+#endif
+	EXPECT_TRUE(tcp_socket_set_keepalive(sock, false, 0, 0, 0));
+	EXPECT_FALSE(tcp_socket_keepalive(sock, nullptr, nullptr, nullptr));
+
+	socket_deallocate(sock);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_ipv4) {
+	network_address_t* address_bind = 0;
+	network_address_t** address_local = 0;
+	network_address_t* address_connect = 0;
+
+	unsigned int iaddr, asize;
+	size_t num_events, ievt;
+	bool got_dataout, got_datain;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	char buffer[64] = {0};
+
+	socket_t* sock_listen = 0;
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	sock_listen = tcp_socket_allocate();
+	sock_client = tcp_socket_allocate();
+
+	network_address_ipv4_t any;
+	network_address_ipv4_initialize(&any);
+	address_bind = (network_address_t*)&any;
+	socket_bind(sock_listen, address_bind);
+
+	tcp_socket_listen(sock_listen);
+	EXPECT_EQ(socket_state(sock_listen), SOCKETSTATE_LISTENING);
+
+	address_local = network_address_local();
+	address_connect = 0;
+	for (iaddr = 0, asize = array_size(address_local); iaddr < asize; ++iaddr) {
+		if (network_address_family(address_local[iaddr]) == NETWORK_ADDRESSFAMILY_IPV4) {
+			address_connect = address_local[iaddr];
+			break;
+		}
+	}
+	EXPECT_NE(address_connect, 0);
+	network_address_ip_set_port(address_connect,
+	                            network_address_ip_port(socket_address_local(sock_listen)));
+	socket_set_blocking(sock_client, false);
+	socket_connect(sock_client, address_connect, 0);
+
+	network_address_array_deallocate(address_local);
+	thread_sleep(100);
+
+	sock_server = tcp_socket_accept(sock_listen, 0);
+	EXPECT_NE(sock_server, 0);
+	EXPECT_INTEQ(socket_poll_state(sock_client), SOCKETSTATE_CONNECTED);
+	socket_set_blocking(sock_server, false);
+
+	//Poll grows beyond initial capacity
+	poll = network_poll_allocate(1);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_listen));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	EXPECT_EQ(network_poll_num_sockets(poll), 3);
+
+	//Removing a socket moves the last socket into its slot
+	network_poll_remove_socket(poll, sock_listen);
+	EXPECT_EQ(network_poll_has_socket(poll, sock_listen), false);
+	EXPECT_TRUE(network_poll_has_socket(poll, sock_server));
+	EXPECT_TRUE(network_poll_has_socket(poll, sock_client));
+	EXPECT_EQ(network_poll_num_sockets(poll), 2);
+
+	network_poll_set_write_interest(poll, sock_client, true);
+	EXPECT_TRUE(network_poll_write_interest(poll, sock_client));
+	got_dataout = false;
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000);
+	for (ievt = 0; ievt < num_events; ++ievt) {
+		if ((events[ievt].event == NETWORKEVENT_DATAOUT) && (events[ievt].socket == sock_client))
+			got_dataout = true;
+		EXPECT_NE(events[ievt].event, NETWORKEVENT_DATAIN);
+	}
+	EXPECT_TRUE(got_dataout);
+	network_poll_set_write_interest(poll, sock_client, false);
+
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	got_datain = false;
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000);
+	for (ievt = 0; ievt < num_events; ++ievt) {
+		if ((events[ievt].event == NETWORKEVENT_DATAIN) && (events[ievt].socket == sock_server))
+			got_datain = true;
+		EXPECT_NE(events[ievt].event, NETWORKEVENT_DATAOUT);
+	}
+	EXPECT_TRUE(got_datain);
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), 0);
+	EXPECT_TRUE(socket_drained(sock_server));
+
+	//Deallocating a socket removes it from the poll
+	socket_deallocate(sock_server);
+	EXPECT_EQ(network_poll_num_sockets(poll), 1);
+
+	network_poll_deallocate(poll);
+
+	socket_deallocate(sock_listen);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_deferred) {
+	size_t num_events, ievt;
+	bool got_datain;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	char buffer[64] = {0};
+
+	socket_t* sock_temp = 0;
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	sock_temp = udp_socket_allocate();
+
+	poll = network_poll_allocate(4);
+	network_poll_set_deferred(poll, true);
+	EXPECT_TRUE(network_poll_deferred(poll));
+
+	//Changes cancelling out before the wait are dropped
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_temp));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	network_poll_remove_socket(poll, sock_temp);
+	network_poll_set_write_interest(poll, sock_client, true);
+	network_poll_set_write_interest(poll, sock_client, false);
+	EXPECT_EQ(network_poll_num_sockets(poll), 2);
+
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	got_datain = false;
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000);
+	for (ievt = 0; ievt < num_events; ++ievt) {
+		if ((events[ievt].event == NETWORKEVENT_DATAIN) && (events[ievt].socket == sock_server))
+			got_datain = true;
+		EXPECT_NE(events[ievt].event, NETWORKEVENT_DATAOUT);
+	}
+	EXPECT_TRUE(got_datain);
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), sizeof(buffer));
+
+	//Removal of an applied registration is deferred as well
+	network_poll_remove_socket(poll, sock_server);
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100);
+	EXPECT_EQ(num_events, 0);
+
+	network_poll_set_deferred(poll, false);
+	EXPECT_EQ(network_poll_deferred(poll), false);
+	network_poll_set_write_interest(poll, sock_client, true);
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000);
+	EXPECT_EQ(num_events, 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAOUT);
+
+	network_poll_deallocate(poll);
+
+	socket_deallocate(sock_temp);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_pending) {
+	network_poll_event_t events[1];
+	network_poll_t* poll;
+	char buffer[64] = {0};
+	size_t ipair;
+
+	socket_t* sock_server[3];
+	socket_t* sock_client[3];
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate(4);
+	for (ipair = 0; ipair < 3; ++ipair) {
+		EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server[ipair], &sock_client[ipair]));
+		EXPECT_TRUE(network_poll_add_socket(poll, sock_server[ipair]));
+		EXPECT_EQ(socket_write(sock_client[ipair], buffer, sizeof(buffer)), sizeof(buffer));
+	}
+	thread_sleep(100);
+
+	//Events exceeding capacity are kept for the next call
+	EXPECT_EQ(network_poll(poll, events, 1, 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(network_poll_num_pending(poll), 2);
+	EXPECT_EQ(socket_read(events[0].socket, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, 1, 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(network_poll_num_pending(poll), 1);
+
+	//Pending event is discarded when the socket is removed
+	for (ipair = 0; ipair < 3; ++ipair)
+		network_poll_remove_socket(poll, sock_server[ipair]);
+	EXPECT_EQ(network_poll_num_pending(poll), 0);
+	EXPECT_EQ(network_poll(poll, events, 1, 0), 0);
+
+	for (ipair = 0; ipair < 3; ++ipair) {
+		socket_deallocate(sock_server[ipair]);
+		socket_deallocate(sock_client[ipair]);
+	}
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_state) {
+	network_poll_event_t events[4];
+	network_poll_t* poll;
+	stream_t* stream;
+	char buffer[64] = {0};
+
+	network_address_ipv4_t address;
+	tick_t start;
+
+	socket_t* sock_listen;
+	socket_t* sock_server;
+	socket_t* sock_client;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate(4);
+
+	//Connection in progress advances when polling state, and the poll reports it
+	sock_listen = tcp_socket_allocate();
+	network_address_ipv4_initialize(&address);
+	network_address_ipv4_set_ip((network_address_t*)&address, network_address_ipv4_make_ip(127, 0, 0, 1));
+	EXPECT_TRUE(socket_bind(sock_listen, (network_address_t*)&address));
+	EXPECT_TRUE(tcp_socket_listen(sock_listen));
+	network_address_ip_set_port((network_address_t*)&address,
+	                            network_address_ip_port(socket_address_local(sock_listen)));
+	sock_client = tcp_socket_allocate();
+	socket_set_blocking(sock_client, false);
+	socket_connect(sock_client, (network_address_t*)&address, 0);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+	start = time_current();
+	while ((socket_poll_state(sock_client) == SOCKETSTATE_CONNECTING) && (time_elapsed(start) < REAL_C(2.0)))
+		thread_sleep(10);
+	EXPECT_INTEQ(socket_poll_state(sock_client), SOCKETSTATE_CONNECTED);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_CONNECTED);
+	EXPECT_EQ(events[0].socket, sock_client);
+	sock_server = tcp_socket_accept(sock_listen, 1000);
+	EXPECT_NE(sock_server, 0);
+	EXPECT_EQ(socket_write(sock_server, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	socket_deallocate(sock_listen);
+
+	//Peer closing with data left to read disconnects the socket until the data is read
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+	stream = socket_stream_allocate(sock_server, 64, 64);
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	socket_deallocate(sock_client);
+	thread_sleep(100);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_INTEQ(socket_poll_state(sock_server), SOCKETSTATE_DISCONNECTED);
+	EXPECT_FALSE(stream_eos(stream));
+	EXPECT_EQ(stream_read(stream, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_TRUE(stream_eos(stream));
+	stream_deallocate(stream);
+	socket_deallocate(sock_server);
+
+	//Peer closing with nothing left to read hangs up the socket
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+	stream = socket_stream_allocate(sock_server, 64, 64);
+	EXPECT_FALSE(stream_eos(stream));
+	socket_deallocate(sock_client);
+	thread_sleep(100);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_HANGUP);
+	EXPECT_TRUE(stream_eos(stream));
+	stream_deallocate(stream);
+	socket_deallocate(sock_server);
+
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_io_uring) {
+	size_t num_events, ievt;
+	bool got_write, got_read;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	char buffer_out[64] = {1};
+	char buffer_in[64] = {0};
+	tick_t start;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate_backend(4, NETWORK_POLL_BACKEND_IO_URING);
+	if (network_poll_backend(poll) != NETWORK_POLL_BACKEND_IO_URING) {
+		EXPECT_EQ(network_poll_submit_read(poll, sock_server, buffer_in, sizeof(buffer_in)), false);
+		network_poll_deallocate(poll);
+		return 0;
+	}
+
+	network_poll_wakeup(poll);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 0);
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+
+	EXPECT_TRUE(network_poll_submit_read(poll, sock_server, buffer_in, sizeof(buffer_in)));
+	EXPECT_TRUE(network_poll_submit_write(poll, sock_client, buffer_out, sizeof(buffer_out)));
+
+	got_write = got_read = false;
+	start = time_current();
+	while ((!got_write || !got_read) && (time_elapsed(start) < REAL_C(2.0))) {
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			if (events[ievt].event == NETWORKEVENT_WRITE_COMPLETE) {
+				EXPECT_EQ(events[ievt].socket, sock_client);
+				EXPECT_EQ(events[ievt].buffer, buffer_out);
+				EXPECT_INTEQ(events[ievt].result, sizeof(buffer_out));
+				got_write = true;
+			}
+			else if (events[ievt].event == NETWORKEVENT_READ_COMPLETE) {
+				EXPECT_EQ(events[ievt].socket, sock_server);
+				EXPECT_EQ(events[ievt].buffer, buffer_in);
+				EXPECT_INTEQ(events[ievt].result, sizeof(buffer_in));
+				got_read = true;
+			}
+		}
+	}
+	EXPECT_TRUE(got_write);
+	EXPECT_TRUE(got_read);
+	EXPECT_EQ(buffer_in[0], 1);
+
+	//Readiness events are delivered through the same interface
+	EXPECT_EQ(socket_write(sock_client, buffer_out, sizeof(buffer_out)), sizeof(buffer_out));
+	got_read = false;
+	start = time_current();
+	while (!got_read && (time_elapsed(start) < REAL_C(2.0))) {
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			if ((events[ievt].event == NETWORKEVENT_DATAIN) && (events[ievt].socket == sock_server))
+				got_read = true;
+		}
+	}
+	EXPECT_TRUE(got_read);
+	EXPECT_EQ(socket_read(sock_server, buffer_in, sizeof(buffer_in)), sizeof(buffer_in));
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_backends) {
+	network_poll_backend_t backends[] = {
+		NETWORK_POLL_BACKEND_EPOLL, NETWORK_POLL_BACKEND_POLL,
+		NETWORK_POLL_BACKEND_IO_URING, NETWORK_POLL_BACKEND_SELECT
+	};
+	size_t ibackend, num_events, ievt;
+	bool got_read, got_write;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	char buffer[64] = {1};
+	tick_t start;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	//Same workload on every backend available, starting at capacity 1 to force growth
+	for (ibackend = 0; ibackend < sizeof(backends) / sizeof(backends[0]); ++ibackend) {
+		poll = network_poll_allocate_backend(1, backends[ibackend]);
+		EXPECT_NE(network_poll_backend(poll), NETWORK_POLL_BACKEND_DEFAULT);
+		if (network_poll_backend(poll) != backends[ibackend]) {
+			network_poll_deallocate(poll);
+			continue;
+		}
+
+		network_poll_wakeup(poll);
+		EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 0);
+
+		EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+		EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+		EXPECT_TRUE(network_poll_add_socket(poll, sock_client));
+
+		EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+		network_poll_set_write_interest(poll, sock_client, true);
+
+		got_read = got_write = false;
+		start = time_current();
+		while ((!got_read || !got_write) && (time_elapsed(start) < REAL_C(2.0))) {
+			num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100);
+			for (ievt = 0; ievt < num_events; ++ievt) {
+				if ((events[ievt].event == NETWORKEVENT_DATAIN) && (events[ievt].socket == sock_server))
+					got_read = true;
+				else if ((events[ievt].event == NETWORKEVENT_DATAOUT) && (events[ievt].socket == sock_client))
+					got_write = true;
+			}
+		}
+		EXPECT_TRUE(got_read);
+		EXPECT_TRUE(got_write);
+		EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), sizeof(buffer));
+
+		//Removed socket and drained socket report nothing
+		network_poll_remove_socket(poll, sock_client);
+		EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+
+		socket_deallocate(sock_server);
+		socket_deallocate(sock_client);
+		network_poll_deallocate(poll);
+	}
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_timers) {
+	size_t num_events, ievt;
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	unsigned int timer_once, timer_repeat;
+	int num_once = 0, num_repeat = 0, num_timeout = 0;
+	char buffer[64] = {0};
+	tick_t start;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate(4);
+
+	//Poll without sockets waits for timers
+	timer_once = network_poll_add_timer(poll, 20, 0, &num_once);
+	timer_repeat = network_poll_add_timer(poll, 10, 10, &num_repeat);
+	EXPECT_NE(timer_once, timer_repeat);
+	EXPECT_EQ(network_poll_num_timers(poll), 2);
+
+	start = time_current();
+	while ((!num_once || (num_repeat < 3)) && (time_elapsed(start) < REAL_C(2.0))) {
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			EXPECT_EQ(events[ievt].event, NETWORKEVENT_TIMER);
+			++(*(int*)events[ievt].buffer);
+		}
+	}
+	EXPECT_INTEQ(num_once, 1);
+	EXPECT_TRUE(num_repeat >= 3);
+	EXPECT_EQ(network_poll_num_timers(poll), 1);
+	network_poll_remove_timer(poll, timer_repeat);
+	EXPECT_EQ(network_poll_num_timers(poll), 0);
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+
+	//Incoming data clears the read deadline
+	network_poll_set_deadline(poll, sock_server, NETWORK_DEADLINE_READ, 500);
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000);
+	EXPECT_EQ(num_events, 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(network_poll_num_timers(poll), 0);
+	EXPECT_EQ(socket_read(sock_server, buffer, sizeof(buffer)), sizeof(buffer));
+
+	network_poll_set_deadline(poll, sock_server, NETWORK_DEADLINE_READ, 20);
+	network_poll_set_deadline(poll, sock_server, NETWORK_DEADLINE_IDLE, 5000);
+	start = time_current();
+	while (!num_timeout && (time_elapsed(start) < REAL_C(2.0))) {
+		num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000);
+		for (ievt = 0; ievt < num_events; ++ievt) {
+			EXPECT_EQ(events[ievt].event, NETWORKEVENT_TIMEOUT);
+			EXPECT_EQ(events[ievt].socket, sock_server);
+			EXPECT_INTEQ(events[ievt].result, NETWORK_DEADLINE_READ);
+			++num_timeout;
+		}
+	}
+	EXPECT_INTEQ(num_timeout, 1);
+	EXPECT_REALLE(time_elapsed(start), REAL_C(0.5));
+
+	//Removing the socket clears its deadlines
+	EXPECT_EQ(network_poll_num_timers(poll), 1);
+	network_poll_remove_socket(poll, sock_server);
+	EXPECT_EQ(network_poll_num_timers(poll), 0);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+typedef struct {
+	socket_t* sock[2];
+	int num_datain;
+	int num_timer;
+} dispatch_test_t;
+
+static void
+dispatch_datain(network_dispatch_t* dispatch, const network_poll_event_t* event, void* context) {
+	dispatch_test_t* test = network_dispatch_context(dispatch, event->socket);
+	char buffer[64];
+	EXPECT_EQ(test, context);
+	socket_read(event->socket, buffer, sizeof(buffer));
+	++test->num_datain;
+	//Deallocating the other socket discards its pending event
+	if (event->socket == test->sock[0]) {
+		socket_deallocate(test->sock[1]);
+		test->sock[1] = 0;
+	}
+	else {
+		socket_deallocate(test->sock[0]);
+		test->sock[0] = 0;
+	}
+}
+
+static void
+dispatch_timer(network_dispatch_t* dispatch, const network_poll_event_t* event, void* context) {
+	dispatch_test_t* test = context;
+	EXPECT_EQ(event->socket, 0);
+	if (++test->num_timer == 3)
+		network_dispatch_stop(dispatch);
+}
+
+DECLARE_TEST(tcp, poll_dispatch) {
+	network_poll_t* poll;
+	network_dispatch_t* dispatch;
+	network_handler_t socket_handler;
+	network_handler_t default_handler;
+	dispatch_test_t test;
+	char buffer[64] = {0};
+	unsigned int timer;
+
+	socket_t* sock_client[2] = {0};
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	memset(&test, 0, sizeof(test));
+	memset(&socket_handler, 0, sizeof(socket_handler));
+	memset(&default_handler, 0, sizeof(default_handler));
+	socket_handler.event[NETWORKEVENT_DATAIN] = dispatch_datain;
+	default_handler.event[NETWORKEVENT_TIMER] = dispatch_timer;
+
+	poll = network_poll_allocate(4);
+	dispatch = network_dispatch_allocate(poll, 0);
+	EXPECT_EQ(network_dispatch_poll(dispatch), poll);
+	network_dispatch_set_default_handler(dispatch, &default_handler, &test);
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&test.sock[0], &sock_client[0]));
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&test.sock[1], &sock_client[1]));
+	EXPECT_TRUE(network_dispatch_add_socket(dispatch, test.sock[0], &socket_handler, &test));
+	EXPECT_TRUE(network_dispatch_add_socket(dispatch, test.sock[1], &socket_handler, &test));
+	EXPECT_EQ(network_dispatch_context(dispatch, test.sock[1]), &test);
+
+	EXPECT_EQ(socket_write(sock_client[0], buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(socket_write(sock_client[1], buffer, sizeof(buffer)), sizeof(buffer));
+	thread_sleep(100);
+
+	//Event of the socket deallocated by the first handler is discarded
+	EXPECT_EQ(network_dispatch(dispatch, 1000), 1);
+	EXPECT_EQ(network_dispatch(dispatch, 0), 0);
+	EXPECT_INTEQ(test.num_datain, 1);
+	EXPECT_EQ(network_poll_num_sockets(poll), 1);
+
+	//Events without socket handler go to the default handler
+	timer = network_poll_add_timer(poll, 10, 10, nullptr);
+	network_dispatch_run(dispatch, 1000);
+	EXPECT_INTEQ(test.num_timer, 3);
+	network_poll_remove_timer(poll, timer);
+
+	socket_deallocate(test.sock[0]);
+	socket_deallocate(test.sock[1]);
+	socket_deallocate(sock_client[0]);
+	socket_deallocate(sock_client[1]);
+	network_dispatch_deallocate(dispatch);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+static void
+dispatch_priority_datain(network_dispatch_t* dispatch, const network_poll_event_t* event, void* context) {
+	int* num_datain = context;
+	char buffer[64];
+	socket_read(event->socket, buffer, sizeof(buffer));
+	++num_datain[network_poll_priority(network_dispatch_poll(dispatch), event->socket)];
+}
+
+DECLARE_TEST(tcp, poll_priority) {
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	network_dispatch_t* dispatch;
+	network_handler_t handler;
+	int num_datain[NETWORK_POLL_PRIORITY_COUNT] = {0};
+	char buffer[64] = {0};
+	size_t isock;
+
+	socket_t* sock_server[3] = {0};
+	socket_t* sock_client[3] = {0};
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate(4);
+	for (isock = 0; isock < 3; ++isock) {
+		EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server[isock], &sock_client[isock]));
+		EXPECT_TRUE(network_poll_add_socket(poll, sock_server[isock]));
+	}
+	network_poll_set_priority(poll, sock_server[1], NETWORK_POLL_PRIORITY_HIGH);
+	network_poll_set_priority(poll, sock_server[2], NETWORK_POLL_PRIORITY_HIGH);
+	EXPECT_EQ(network_poll_priority(poll, sock_server[0]), NETWORK_POLL_PRIORITY_NORMAL);
+	EXPECT_EQ(network_poll_priority(poll, sock_server[1]), NETWORK_POLL_PRIORITY_HIGH);
+
+	for (isock = 0; isock < 3; ++isock)
+		EXPECT_EQ(socket_write(sock_client[isock], buffer, sizeof(buffer)), sizeof(buffer));
+	thread_sleep(100);
+
+	//High priority events are returned first regardless of capacity
+	EXPECT_EQ(network_poll(poll, events, 1, 1000), 1);
+	EXPECT_EQ(network_poll_priority(poll, events[0].socket), NETWORK_POLL_PRIORITY_HIGH);
+	EXPECT_EQ(network_poll_num_pending(poll), 2);
+	EXPECT_EQ(socket_read(events[0].socket, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, 1, 0), 1);
+	EXPECT_EQ(network_poll_priority(poll, events[0].socket), NETWORK_POLL_PRIORITY_HIGH);
+	EXPECT_EQ(socket_read(events[0].socket, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, 1, 0), 1);
+	EXPECT_EQ(events[0].socket, sock_server[0]);
+	EXPECT_EQ(socket_read(events[0].socket, buffer, sizeof(buffer)), sizeof(buffer));
+
+	//Class budget defers high priority events exceeding it to the next iteration
+	for (isock = 0; isock < 3; ++isock)
+		EXPECT_EQ(socket_write(sock_client[isock], buffer, sizeof(buffer)), sizeof(buffer));
+	thread_sleep(100);
+	memset(&handler, 0, sizeof(handler));
+	handler.event[NETWORKEVENT_DATAIN] = dispatch_priority_datain;
+	dispatch = network_dispatch_allocate(poll, 0);
+	network_dispatch_set_default_handler(dispatch, &handler, num_datain);
+	network_dispatch_set_class_budget(dispatch, NETWORK_POLL_PRIORITY_HIGH, 1);
+	EXPECT_EQ(network_dispatch(dispatch, 1000), 2);
+	EXPECT_INTEQ(num_datain[NETWORK_POLL_PRIORITY_HIGH], 1);
+	EXPECT_INTEQ(num_datain[NETWORK_POLL_PRIORITY_NORMAL], 1);
+	EXPECT_EQ(network_poll_num_pending(poll), 1);
+	EXPECT_EQ(network_dispatch(dispatch, 0), 1);
+	EXPECT_INTEQ(num_datain[NETWORK_POLL_PRIORITY_HIGH], 2);
+
+	//Backlog of low priority events over budget does not hold back a new high priority event
+	network_dispatch_set_class_budget(dispatch, NETWORK_POLL_PRIORITY_HIGH, 0);
+	network_dispatch_set_class_budget(dispatch, NETWORK_POLL_PRIORITY_LOW, 1);
+	network_poll_set_priority(poll, sock_server[0], NETWORK_POLL_PRIORITY_LOW);
+	network_poll_set_priority(poll, sock_server[2], NETWORK_POLL_PRIORITY_LOW);
+	EXPECT_EQ(socket_write(sock_client[0], buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(socket_write(sock_client[2], buffer, sizeof(buffer)), sizeof(buffer));
+	thread_sleep(100);
+	memset(num_datain, 0, sizeof(num_datain));
+	EXPECT_EQ(network_dispatch(dispatch, 1000), 1);
+	EXPECT_INTEQ(num_datain[NETWORK_POLL_PRIORITY_LOW], 1);
+	EXPECT_EQ(network_poll_num_pending(poll), 1);
+	EXPECT_EQ(socket_write(sock_client[1], buffer, sizeof(buffer)), sizeof(buffer));
+	thread_sleep(100);
+	EXPECT_EQ(network_dispatch(dispatch, 0), 2);
+	EXPECT_INTEQ(num_datain[NETWORK_POLL_PRIORITY_HIGH], 1);
+	EXPECT_INTEQ(num_datain[NETWORK_POLL_PRIORITY_LOW], 2);
+	EXPECT_EQ(network_poll_num_pending(poll), 0);
+	network_dispatch_deallocate(dispatch);
+
+	network_poll_remove_socket(poll, sock_server[1]);
+	EXPECT_EQ(network_poll_priority(poll, sock_server[1]), NETWORK_POLL_PRIORITY_NORMAL);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+
+	for (isock = 0; isock < 3; ++isock) {
+		socket_deallocate(sock_server[isock]);
+		socket_deallocate(sock_client[isock]);
+	}
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_wakeup) {
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	tick_t start;
+	char buffer[64] = {0};
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate(4);
+
+	//Wakeup interrupts an infinite wait, also without sockets
+	start = time_current();
+	network_poll_wakeup(poll);
+	network_poll_wakeup(poll);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 0);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+	EXPECT_REALLE(time_elapsed(start), REAL_C(0.5));
+
+	//Queued socket is added by the next poll call
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	network_poll_queue_add_socket(poll, sock_server);
+	EXPECT_EQ(network_poll_num_queued(poll), 1);
+	EXPECT_FALSE(network_poll_has_socket(poll, sock_server));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 0);
+	EXPECT_EQ(network_poll_num_queued(poll), 0);
+	EXPECT_TRUE(network_poll_has_socket(poll, sock_server));
+
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+
+	network_poll_queue_remove_socket(poll, sock_server);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), NETWORK_TIMEOUT_INFINITE), 0);
+	EXPECT_FALSE(network_poll_has_socket(poll, sock_server));
+
+	//Deallocating a socket discards its queued requests
+	network_poll_queue_add_socket(poll, sock_client);
+	EXPECT_EQ(network_poll_num_queued(poll), 1);
+	socket_deallocate(sock_client);
+	EXPECT_EQ(network_poll_num_queued(poll), 0);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+	EXPECT_EQ(network_poll_num_sockets(poll), 0);
+
+	socket_deallocate(sock_server);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+DECLARE_TEST(tcp, poll_beacon) {
+	network_poll_event_t events[8];
+	network_poll_t* poll;
+	beacon_t beacon;
+	char buffer[64] = {0};
+	int index;
+
+	socket_t* sock_server = 0;
+	socket_t* sock_client = 0;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	poll = network_poll_allocate(4);
+	beacon_initialize(&beacon);
+
+	index = network_poll_set_beacon(poll, &beacon);
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	EXPECT_TRUE(index > 0);
+#else
+	if (index < 0) {
+		beacon_finalize(&beacon);
+		network_poll_deallocate(poll);
+		return 0;
+	}
+#endif
+
+	EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server, &sock_client));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+
+	//Beacon fired by foundation side
+	beacon_fire(&beacon);
+	EXPECT_INTEQ(beacon_wait(&beacon, network_poll_prepare(poll, 1000)), 0);
+
+	//Beacon fired by socket in poll
+	EXPECT_EQ(socket_write(sock_client, buffer, sizeof(buffer)), sizeof(buffer));
+	EXPECT_INTEQ(beacon_wait(&beacon, network_poll_prepare(poll, 1000)), index);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+
+	//Pending timer expiry bounds the wait
+	network_poll_add_timer(poll, 20, 0, nullptr);
+	EXPECT_TRUE(network_poll_prepare(poll, NETWORK_TIMEOUT_INFINITE) <= 20);
+
+	EXPECT_INTEQ(network_poll_set_beacon(poll, nullptr), -1);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	beacon_finalize(&beacon);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+static void
+poll_group_handler(network_poll_group_t* group, network_poll_t* poll,
+                   network_poll_event_t* events, size_t num_events) {
+	atomic32_t* received = network_poll_group_context(group);
+	char buffer[64];
+	size_t ievt;
+	FOUNDATION_UNUSED(poll);
+	for (ievt = 0; ievt < num_events; ++ievt) {
+		if (events[ievt].event == NETWORKEVENT_DATAIN) {
+			size_t read = socket_read(events[ievt].socket, buffer, sizeof(buffer));
+			atomic_add32(received, (int32_t)read, memory_order_release);
+		}
+	}
+}
+
+DECLARE_TEST(tcp, poll_group) {
+	network_poll_group_t* group;
+	atomic32_t received;
+	char buffer[64] = {0};
+	size_t ipair, ishard;
+	tick_t start;
+
+	socket_t* sock_server[4];
+	socket_t* sock_client[4];
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	atomic_store32(&received, 0, memory_order_release);
+
+	group = network_poll_group_allocate(2, 8, poll_group_handler, &received);
+	EXPECT_EQ(network_poll_group_num_polls(group), 2);
+	EXPECT_TRUE(network_poll_group_start(group, NETWORK_TIMEOUT_INFINITE));
+
+	for (ipair = 0; ipair < 4; ++ipair) {
+		EXPECT_TRUE(tcp_connected_pair_ipv4(&sock_server[ipair], &sock_client[ipair]));
+		network_poll_group_add_socket(group, sock_server[ipair]);
+	}
+
+	//Least loaded assignment spreads sockets evenly
+	thread_sleep(100);
+	network_poll_group_stop(group);
+	for (ishard = 0; ishard < 2; ++ishard)
+		EXPECT_EQ(network_poll_num_sockets(network_poll_group_poll(group, ishard)), 2);
+
+	network_poll_group_migrate_socket(group, sock_server[0], 1);
+	EXPECT_TRUE(network_poll_has_socket(network_poll_group_poll(group, 1), sock_server[0]));
+	EXPECT_TRUE(network_poll_group_start(group, NETWORK_TIMEOUT_INFINITE));
+
+	for (ipair = 0; ipair < 4; ++ipair)
+		EXPECT_EQ(socket_write(sock_client[ipair], buffer, sizeof(buffer)), sizeof(buffer));
+
+	start = time_current();
+	while ((atomic_load32(&received, memory_order_acquire) < 4 * (int32_t)sizeof(buffer)) &&
+	       (time_elapsed(start) < REAL_C(2.0)))
+		thread_sleep(10);
+	EXPECT_INTEQ(atomic_load32(&received, memory_order_acquire), 4 * (int)sizeof(buffer));
+
+	network_poll_group_stop(group);
+
+	for (ipair = 0; ipair < 4; ++ipair) {
+		socket_deallocate(sock_server[ipair]);
+		socket_deallocate(sock_client[ipair]);
+	}
+
+	network_poll_group_deallocate(group);
+
+	return 0;
+}
+
 static void
 test_tcp_declare(void) {
 	ADD_TEST(tcp, connect_ipv4);
 	ADD_TEST(tcp, connect_ipv6);
+	ADD_TEST(tcp, connect_refused);
 	ADD_TEST(tcp, io_ipv4);
 	ADD_TEST(tcp, io_ipv6);
 	ADD_TEST(tcp, stream_ipv4);
 	ADD_TEST(tcp, stream_ipv6);
+	ADD_TEST(tcp, poll_edge_triggered);
+	ADD_TEST(tcp, io_vectored);
+	ADD_TEST(tcp, io_zerocopy);
+	ADD_TEST(tcp, io_queue);
+	ADD_TEST(tcp, io_sendfile);
+	ADD_TEST(tcp, options);
+	ADD_TEST(tcp, poll_ipv4);
+	ADD_TEST(tcp, poll_deferred);
+	ADD_TEST(tcp, poll_pending);
+	ADD_TEST(tcp, poll_state);
+	ADD_TEST(tcp, poll_io_uring);
+	ADD_TEST(tcp, poll_backends);
+	ADD_TEST(tcp, poll_timers);
+	ADD_TEST(tcp, poll_dispatch);
+	ADD_TEST(tcp, poll_priority);
+	ADD_TEST(tcp, poll_wakeup);
+	ADD_TEST(tcp, poll_beacon);
+	ADD_TEST(tcp, poll_group);
 }
 
 static test_suite_t test_tcp_suite = {
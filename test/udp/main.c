@@ -509,12 +509,344 @@ DECLARE_TEST(udp, datagram_ipv6) {
 	return 0;
 }
 
+static bool
+udp_bound_pair_ipv4(socket_t** sock_server, socket_t** sock_client) {
+	network_address_t** address_local = 0;
+	network_address_t* address_bind = 0;
+	unsigned int iaddr, asize;
+	bool bound = false;
+
+	*sock_server = udp_socket_allocate();
+	*sock_client = udp_socket_allocate();
+
+	address_local = network_address_local();
+	for (iaddr = 0, asize = array_size(address_local); iaddr < asize; ++iaddr) {
+		if (network_address_family(address_local[iaddr]) == NETWORK_ADDRESSFAMILY_IPV4) {
+			address_bind = address_local[iaddr];
+			break;
+		}
+	}
+	if (address_bind) {
+		network_address_ip_set_port(address_bind, 0);
+		bound = socket_bind(*sock_server, address_bind);
+	}
+
+	network_address_array_deallocate(address_local);
+
+	if (!bound) {
+		socket_deallocate(*sock_server);
+		socket_deallocate(*sock_client);
+		*sock_server = *sock_client = 0;
+		return false;
+	}
+
+	socket_set_blocking(*sock_server, false);
+	return true;
+}
+
+DECLARE_TEST(udp, poll_edge_triggered) {
+#if FOUNDATION_PLATFORM_LINUX || FOUNDATION_PLATFORM_ANDROID
+	network_poll_event_t events[4];
+	network_poll_t* poll;
+	const network_address_t* address;
+	char buffer[64] = {0};
+
+	socket_t* sock_server;
+	socket_t* sock_client;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(udp_bound_pair_ipv4(&sock_server, &sock_client));
+	address = socket_address_local(sock_server);
+
+	poll = network_poll_allocate(4);
+	network_poll_set_edge_triggered(poll, true);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	thread_sleep(10);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_server);
+
+	//Datagram left queued is not reported again, socket is drained by reading until none remain
+	EXPECT_EQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), 0), sizeof(buffer));
+	EXPECT_FALSE(socket_drained(sock_server));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 100), 0);
+	EXPECT_EQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), 0), sizeof(buffer));
+	EXPECT_EQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), 0), 0);
+	EXPECT_TRUE(socket_drained(sock_server));
+
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_FALSE(socket_drained(sock_server));
+
+	network_poll_deallocate(poll);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+#endif
+	return 0;
+}
+
+DECLARE_TEST(udp, poll_busy) {
+	const network_address_t* address;
+	network_poll_event_t events[4];
+	network_poll_statistics_t stats;
+	network_poll_t* poll;
+	const network_address_t* from;
+	char buffer[64] = {0};
+
+	socket_t* sock_server;
+	socket_t* sock_client;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(udp_bound_pair_ipv4(&sock_server, &sock_client));
+	address = socket_address_local(sock_server);
+
+	poll = network_poll_allocate(4);
+	network_poll_set_busy_poll(poll, 2000);
+	EXPECT_EQ(network_poll_busy_poll(poll), 2000);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+
+	//No data, spin for the budget then block for the remaining timeout
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+	stats = network_poll_statistics(poll);
+	EXPECT_TRUE(stats.spins > 0);
+	EXPECT_EQ(stats.spin_hits, 0);
+	EXPECT_EQ(stats.sleeps, 1);
+
+	network_poll_reset_statistics(poll);
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	thread_sleep(10);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), &from), sizeof(buffer));
+	stats = network_poll_statistics(poll);
+	EXPECT_EQ(stats.spin_hits, 1);
+	EXPECT_EQ(stats.sleeps, 0);
+
+	//Wakeup ends the spin without counting as a hit
+	network_poll_reset_statistics(poll);
+	network_poll_wakeup(poll);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 0);
+	stats = network_poll_statistics(poll);
+	EXPECT_EQ(stats.spin_hits, 0);
+	EXPECT_EQ(stats.sleeps, 0);
+
+	network_poll_set_busy_poll(poll, 0);
+	EXPECT_EQ(network_poll_busy_poll(poll), 0);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+static void
+poll_stall(network_poll_t* poll, uint64_t stallus, void* context) {
+	uint64_t* stalled = context;
+	FOUNDATION_UNUSED(poll);
+	*stalled = stallus;
+}
+
+DECLARE_TEST(udp, poll_instrument) {
+	const network_address_t* address;
+	network_poll_event_t events[4];
+	network_poll_statistics_t stats;
+	network_poll_t* poll;
+	const network_address_t* from;
+	uint64_t stalled = 0;
+	char buffer[64] = {0};
+
+	socket_t* sock_server;
+	socket_t* sock_client;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(udp_bound_pair_ipv4(&sock_server, &sock_client));
+	address = socket_address_local(sock_server);
+
+	poll = network_poll_allocate(4);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_server));
+	EXPECT_FALSE(network_poll_instrumented(poll));
+	network_poll_set_instrumented(poll, true);
+	EXPECT_TRUE(network_poll_instrumented(poll));
+	network_poll_set_watchdog(poll, 20000, poll_stall, &stalled);
+
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	thread_sleep(10);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(udp_socket_recvfrom(sock_server, buffer, sizeof(buffer), &from), sizeof(buffer));
+	EXPECT_EQ(stalled, 0);
+
+	stats = network_poll_statistics(poll);
+	EXPECT_EQ(stats.wait.count, 2);
+	EXPECT_EQ(stats.process.count, 2);
+	EXPECT_EQ(stats.events.count, 2);
+	EXPECT_EQ(stats.events.sum, 1);
+	EXPECT_EQ(stats.events.max, 1);
+	EXPECT_EQ(stats.gap.count, 1);
+	EXPECT_TRUE(stats.wait.sum >= 5000);
+	EXPECT_EQ(network_poll_histogram_percentile(&stats.events, REAL_C(0.5)), 0);
+	EXPECT_EQ(network_poll_histogram_percentile(&stats.events, REAL_C(1.0)), 1);
+	EXPECT_TRUE(network_poll_histogram_percentile(&stats.wait, REAL_C(1.0)) <= stats.wait.max);
+
+	//Loop stalling beyond the threshold is reported on the next poll
+	thread_sleep(50);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 0), 0);
+	EXPECT_TRUE(stalled >= 20000);
+	stats = network_poll_statistics(poll);
+	EXPECT_EQ(stats.stalls, 1);
+	EXPECT_EQ(stats.gap.count, 2);
+	EXPECT_EQ(stats.gap.max, stalled);
+
+	//Empty busy poll spins are not recorded, only the final blocking wait
+	network_poll_reset_statistics(poll);
+	network_poll_set_busy_poll(poll, 2000);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+	stats = network_poll_statistics(poll);
+	EXPECT_TRUE(stats.spins > 0);
+	EXPECT_EQ(stats.wait.count, 1);
+	EXPECT_EQ(stats.process.count, 1);
+	EXPECT_EQ(stats.events.count, 1);
+
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
+DECLARE_TEST(udp, poll_fd) {
+	network_address_t* address = 0;
+	network_poll_event_t events[4];
+	network_poll_t* poll;
+	char buffer[64] = {0};
+	int user_data = 0;
+
+	socket_t* sock_server;
+	socket_t* sock_client;
+	socket_t* sock_temp;
+	socket_t* sock_reuse;
+	socket_t* sock_many[24];
+	size_t isock;
+
+	if (!network_supports_ipv4())
+		return 0;
+
+	EXPECT_TRUE(udp_bound_pair_ipv4(&sock_server, &sock_client));
+	address = network_address_clone(socket_address_local(sock_server));
+
+	//Descriptor is polled raw, without the socket being part of the poll
+	poll = network_poll_allocate(4);
+	EXPECT_TRUE(network_poll_add_fd(poll, socket_fd(sock_server), NETWORK_POLLFD_READ, &user_data));
+	EXPECT_FALSE(network_poll_add_fd(poll, socket_fd(sock_server), NETWORK_POLLFD_READ, &user_data));
+	EXPECT_EQ(network_poll_num_fds(poll), 1);
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_FD);
+	EXPECT_EQ(events[0].socket, 0);
+	EXPECT_EQ(events[0].buffer, &user_data);
+	EXPECT_INTEQ(events[0].result, NETWORK_POLLFD_READ);
+
+	//Interest cleared, data still pending on descriptor
+	EXPECT_TRUE(network_poll_update_fd(poll, socket_fd(sock_server), 0));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+
+	network_poll_remove_fd(poll, socket_fd(sock_server));
+	EXPECT_EQ(network_poll_num_fds(poll), 0);
+
+	//Descriptors past the initial lookup table size stay found while others are removed
+	for (isock = 0; isock < sizeof(sock_many) / sizeof(sock_many[0]); ++isock) {
+		sock_many[isock] = udp_socket_allocate();
+		network_address_ip_set_port(address, 0);
+		EXPECT_TRUE(socket_bind(sock_many[isock], address));
+		EXPECT_TRUE(network_poll_add_fd(poll, socket_fd(sock_many[isock]), NETWORK_POLLFD_READ, sock_many[isock]));
+	}
+	EXPECT_SIZEEQ(network_poll_num_fds(poll), sizeof(sock_many) / sizeof(sock_many[0]));
+	for (isock = 0; isock < sizeof(sock_many) / sizeof(sock_many[0]); isock += 2)
+		network_poll_remove_fd(poll, socket_fd(sock_many[isock]));
+	EXPECT_SIZEEQ(network_poll_num_fds(poll), sizeof(sock_many) / sizeof(sock_many[0]) / 2);
+	for (isock = 0; isock < sizeof(sock_many) / sizeof(sock_many[0]); ++isock) {
+		EXPECT_EQ(network_poll_update_fd(poll, socket_fd(sock_many[isock]), NETWORK_POLLFD_READ), (isock % 2) != 0);
+		EXPECT_EQ(network_poll_add_fd(poll, socket_fd(sock_many[isock]), NETWORK_POLLFD_READ, sock_many[isock]), (isock % 2) == 0);
+	}
+	network_address_ip_set_port(address, network_address_ip_port(socket_address_local(sock_many[7])));
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_FD);
+	EXPECT_EQ(events[0].buffer, sock_many[7]);
+	for (isock = 0; isock < sizeof(sock_many) / sizeof(sock_many[0]); ++isock) {
+		network_poll_remove_fd(poll, socket_fd(sock_many[isock]));
+		socket_deallocate(sock_many[isock]);
+	}
+	EXPECT_EQ(network_poll_num_fds(poll), 0);
+
+	//Deferred removal of a closed socket leaves a descriptor reusing its number registered
+	network_poll_set_deferred(poll, true);
+	sock_temp = udp_socket_allocate();
+	network_address_ip_set_port(address, 0);
+	EXPECT_TRUE(socket_bind(sock_temp, address));
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_temp));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 0);
+	network_poll_remove_socket(poll, sock_temp);
+	socket_deallocate(sock_temp);
+
+	sock_reuse = udp_socket_allocate();
+	EXPECT_TRUE(socket_bind(sock_reuse, address));
+	network_address_ip_set_port(address, network_address_ip_port(socket_address_local(sock_reuse)));
+	EXPECT_TRUE(network_poll_add_fd(poll, socket_fd(sock_reuse), NETWORK_POLLFD_READ, &user_data));
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_FD);
+	EXPECT_EQ(events[0].buffer, &user_data);
+	network_poll_remove_fd(poll, socket_fd(sock_reuse));
+
+	//Socket closed and reopened with the same descriptor number while in the poll is registered again
+	network_poll_set_deferred(poll, false);
+	EXPECT_TRUE(network_poll_add_socket(poll, sock_reuse));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 10), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	socket_close(sock_reuse);
+	network_address_ip_set_port(address, 0);
+	EXPECT_TRUE(socket_bind(sock_reuse, address));
+	network_address_ip_set_port(address, network_address_ip_port(socket_address_local(sock_reuse)));
+	network_poll_update_socket(poll, sock_reuse);
+	EXPECT_EQ(udp_socket_sendto(sock_client, buffer, sizeof(buffer), address), sizeof(buffer));
+	EXPECT_EQ(network_poll(poll, events, sizeof(events) / sizeof(events[0]), 1000), 1);
+	EXPECT_EQ(events[0].event, NETWORKEVENT_DATAIN);
+	EXPECT_EQ(events[0].socket, sock_reuse);
+	network_poll_remove_socket(poll, sock_reuse);
+
+	memory_deallocate(address);
+	socket_deallocate(sock_reuse);
+	socket_deallocate(sock_server);
+	socket_deallocate(sock_client);
+	network_poll_deallocate(poll);
+
+	return 0;
+}
+
 static void
 test_udp_declare(void) {
 	ADD_TEST(udp, stream_ipv4);
 	ADD_TEST(udp, stream_ipv6);
 	ADD_TEST(udp, datagram_ipv4);
 	ADD_TEST(udp, datagram_ipv6);
+	ADD_TEST(udp, poll_edge_triggered);
+	ADD_TEST(udp, poll_busy);
+	ADD_TEST(udp, poll_instrument);
+	ADD_TEST(udp, poll_fd);
 }
 
 static test_suite_t test_udp_suite = {
@@ -25,6 +25,7 @@ typedef struct {
 	//Server args
 	network_address_t**     bind;
 	bool                    daemon;
+	network_poll_backend_t  backend;
 
 	//Client args
 	network_address_t***    target;
@@ -80,7 +81,7 @@ main_run(void* main_arg) {
 	blast_input_t input = blast_parse_command_line(environment_command_line());
 
 	if (input.mode == BLAST_SERVER)
-		result = blast_server(input.bind, input.daemon);
+		result = blast_server(input.bind, input.daemon, input.backend);
 	else if (input.mode == BLAST_CLIENT)
 		result = blast_client(input.target, input.files);
 	else
@@ -127,6 +128,18 @@ blast_parse_command_line(const string_const_t* cmdline) {
 					array_push(input.bind, resolved[addr]);
 			}
 		}
+		else if (string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("--backend"))) {
+			if (++arg < asize) {
+				if (string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("epoll")))
+					input.backend = NETWORK_POLL_BACKEND_EPOLL;
+				else if (string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("poll")))
+					input.backend = NETWORK_POLL_BACKEND_POLL;
+				else if (string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("io_uring")))
+					input.backend = NETWORK_POLL_BACKEND_IO_URING;
+				else if (string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("select")))
+					input.backend = NETWORK_POLL_BACKEND_SELECT;
+			}
+		}
 		else if (string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("-t")) ||
 		         string_equal(STRING_ARGS(cmdline[arg]), STRING_CONST("--target"))) {
 			if (++arg < asize) {
@@ -161,6 +174,7 @@ blast_print_usage(void) {
 	             "      <file>                   File name (muliple)\n"
 	             "    Optional arguments:\n"
 	             "      -d|--daemon              Run server as daemon\n"
+	             "      --backend name           Server poll backend (epoll, poll, io_uring or select)\n"
 	             "      --                       Stop parsing command line options\n"
 	         ));
 }
@@ -14,6 +14,7 @@
 #include "writer.h"
 
 #define BLAST_SERVER_TIMEOUT 30
+#define BLAST_SERVER_ACK_INTERVAL 10
 
 typedef struct blast_server_source_t {
 	network_address_t*       address;
@@ -49,12 +50,6 @@ blast_server_source_deallocate(blast_server_source_t* source) {
 	memory_deallocate(source);
 }
 
-static unsigned int
-blast_server_time_until_ack(blast_server_t* server) {
-	FOUNDATION_UNUSED(server);
-	return 10;
-}
-
 static void
 blast_server_send_ack(blast_server_source_t* source) {
 	packet_ack_t packet;
@@ -299,48 +294,55 @@ blast_server_tick(blast_server_t* server) {
 			--ssize;
 		}
 		else {
-			blast_server_send_acks(server);
 			++isrc;
 		}
 	}
 }
 
+static void
+blast_server_on_datain(network_dispatch_t* dispatch, const network_poll_event_t* event, void* context) {
+	FOUNDATION_UNUSED(dispatch);
+	blast_server_read(context, event->socket);
+}
+
+static void
+blast_server_on_timer(network_dispatch_t* dispatch, const network_poll_event_t* event, void* context) {
+	FOUNDATION_UNUSED(dispatch);
+	FOUNDATION_UNUSED(event);
+	blast_server_send_acks(context);
+}
+
 static int
 blast_server_run(bool daemon, network_poll_t* poll, blast_server_t* server) {
 	int result = BLAST_RESULT_OK;
-	bool complete;
+	network_dispatch_t* dispatch;
+	network_handler_t handler;
 
 	if (daemon) {
 		//TODO: Implement
 	}
 
-	network_poll_event_t events[64];
+	memset(&handler, 0, sizeof(handler));
+	handler.event[NETWORKEVENT_DATAIN] = blast_server_on_datain;
+	handler.event[NETWORKEVENT_TIMER] = blast_server_on_timer;
+
+	dispatch = network_dispatch_allocate(poll, 64);
+	network_dispatch_set_default_handler(dispatch, &handler, server);
+
+	//Ack timer also bounds the poll wait, keeping system event processing responsive
+	unsigned int ack_timer = network_poll_add_timer(poll, BLAST_SERVER_ACK_INTERVAL,
+	                                                BLAST_SERVER_ACK_INTERVAL, server);
 	while (!blast_should_exit()) {
-		size_t num_events = network_poll(poll, events, sizeof(events) / sizeof(events[0]),
-		                                 blast_server_time_until_ack(server));
-		size_t ievt;
-
-		for (ievt = 0; ievt < num_events; ++ievt) {
-			switch (events[ievt].event) {
-			case NETWORKEVENT_DATAIN:
-				complete = blast_server_read(server, events[ievt].socket);
-				if (complete) {
-
-				}
-				break;
-			case NETWORKEVENT_CONNECTION:
-			case NETWORKEVENT_CONNECTED:
-			case NETWORKEVENT_ERROR:
-			case NETWORKEVENT_HANGUP:
-			default:
-				break;
-			}
-		}
+		network_dispatch(dispatch, NETWORK_TIMEOUT_INFINITE);
+
 		blast_process_system_events();
 
 		blast_server_tick(server);
 	}
 
+	network_poll_remove_timer(poll, ack_timer);
+	network_dispatch_deallocate(dispatch);
+
 	return result;
 }
 
@@ -359,14 +361,14 @@ blast_server_deallocate(blast_server_t* server) {
 }
 
 int
-blast_server(network_address_t** bind, bool daemon) {
+blast_server(network_address_t** bind, bool daemon, network_poll_backend_t backend) {
 	unsigned int isock, asize, added = 0;
 	int result = BLAST_RESULT_OK;
 	unsigned int port = 0;
 	network_poll_t* poll = 0;
 	blast_server_t* server = 0;
 
-	poll = network_poll_allocate(array_size(bind));
+	poll = network_poll_allocate_backend(array_size(bind), backend);
 
 	for (isock = 0, asize = array_size(bind); isock < asize; ++isock) {
 		socket_t* sock = udp_socket_allocate();
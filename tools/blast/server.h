@@ -12,4 +12,4 @@
 #pragma once
 
 extern int
-blast_server(network_address_t** bind, bool daemon);
+blast_server(network_address_t** bind, bool daemon, network_poll_backend_t backend);